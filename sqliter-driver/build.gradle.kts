@@ -18,7 +18,7 @@ fun configInterop(target: org.jetbrains.kotlin.gradle.plugin.mpp.KotlinNativeTar
 //      extraOpts = listOf("-mode", "sourcecode")
     }
 
-    target.compilations.forEach { kotlinNativeCompilation ->
+    target.compilations.all { kotlinNativeCompilation ->
         kotlinNativeCompilation.kotlinOptions.freeCompilerArgs += when {
             HostManager.hostIsLinux -> listOf(
                 "-linker-options",
@@ -60,12 +60,36 @@ kotlin {
             configInterop(target)
         }
 
+    // Benchmarks live in src/linuxX64Benchmark and run on linuxX64 only:
+    // ./gradlew :sqliter-driver:runBenchmarkReleaseExecutableLinuxX64 -PbenchmarkArgs="--out=results.json"
+    linuxX64 {
+        val main by compilations.getting
+        val benchmark by compilations.creating {
+            associateWith(main)
+        }
+        binaries {
+            executable("benchmark", listOf(RELEASE)) {
+                compilation = benchmark
+                entryPoint = "co.touchlab.sqliter.benchmark.main"
+                runTask?.apply {
+                    doFirst { project.layout.buildDirectory.dir("reports/benchmark").get().asFile.mkdirs() }
+                    val benchmarkArgs = project.findProperty("benchmarkArgs")?.toString()
+                    args(
+                        benchmarkArgs?.split(" ")?.filter { it.isNotBlank() }
+                            ?: listOf("--out=${project.layout.buildDirectory.get().asFile}/reports/benchmark/results.json")
+                    )
+                }
+            }
+        }
+    }
+
     sourceSets {
         all {
             languageSettings.apply {
                 optIn("kotlin.experimental.ExperimentalNativeApi")
                 optIn("kotlinx.cinterop.ExperimentalForeignApi")
                 optIn("kotlinx.cinterop.BetaInteropApi")
+                optIn("kotlin.native.concurrent.ObsoleteWorkersApi")
             }
         }
         commonMain {
@@ -84,8 +108,13 @@ kotlin {
         val appleMain = sourceSets.maybeCreate("appleMain").apply {
             dependsOn(nativeCommonMain)
         }
+        // pthread code shared by linux and mingw. Each compiles it against its own platform.posix, which name some
+        // pthread types differently, so it's a shared directory rather than a commonized source set.
+        val pthreadSrcDir = "src/pthreadMain/kotlin"
+
         val linuxMain = sourceSets.maybeCreate("linuxMain").apply {
             dependsOn(nativeCommonMain)
+            kotlin.srcDir(pthreadSrcDir)
         }
         val linuxX64Main = sourceSets.maybeCreate("linuxX64Main").apply {
             dependsOn(linuxMain)
@@ -100,6 +129,7 @@ kotlin {
 
         val mingwX64Main = sourceSets.maybeCreate("mingwX64Main").apply {
             dependsOn(mingwMain)
+            kotlin.srcDir(pthreadSrcDir)
         }
 
         knTargets.forEach { target ->
@@ -134,3 +164,11 @@ listOf(
     "mingwX64Test",
     "linkDebugTestMingwX64",
 ).forEach { tasks.findByName(it)?.enabled = false }
+
+// The benchmark links against the host's libsqlite3, so it can only be built on Linux
+if (!HostManager.hostIsLinux) {
+    listOf(
+        "linkBenchmarkReleaseExecutableLinuxX64",
+        "runBenchmarkReleaseExecutableLinuxX64",
+    ).forEach { tasks.findByName(it)?.enabled = false }
+}
@@ -0,0 +1,31 @@
+package co.touchlab.sqliter.concurrency
+
+import platform.Foundation.NSCondition
+import platform.Foundation.NSDate
+import platform.Foundation.dateWithTimeIntervalSinceNow
+
+internal actual class Condition actual constructor() {
+    private val c = NSCondition()
+    actual fun lock() {
+        c.lock()
+    }
+
+    actual fun unlock() {
+        c.unlock()
+    }
+
+    actual fun await() {
+        c.wait()
+    }
+
+    actual fun await(timeoutNanos: Long) {
+        c.waitUntilDate(NSDate.dateWithTimeIntervalSinceNow(timeoutNanos / 1_000_000_000.0))
+    }
+
+    actual fun signalAll() {
+        c.broadcast()
+    }
+}
+
+@Suppress("NOTHING_TO_INLINE")
+internal actual inline fun Condition.close() {}
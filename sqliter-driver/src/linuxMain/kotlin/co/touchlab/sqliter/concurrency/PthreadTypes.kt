@@ -0,0 +1,8 @@
+package co.touchlab.sqliter.concurrency
+
+import platform.posix.pthread_cond_t
+import platform.posix.pthread_mutex_t
+
+//Variable types for the shared pthread Condition. mingw names them differently.
+internal typealias PthreadMutexVar = pthread_mutex_t
+internal typealias PthreadCondVar = pthread_cond_t
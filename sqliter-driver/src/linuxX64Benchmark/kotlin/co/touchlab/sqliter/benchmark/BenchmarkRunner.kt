@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package co.touchlab.sqliter.benchmark
+
+import kotlin.math.sqrt
+import kotlin.system.getTimeNanos
+
+/**
+ * Runs each benchmark for [warmup] untimed iterations, then [iterations] timed ones. One iteration performs
+ * opsPerIteration operations, so per-op numbers are iteration time divided by that.
+ */
+class BenchmarkRunner(
+    private val warmup: Int,
+    private val iterations: Int,
+    private val filter: String?
+) {
+    val results = ArrayList<BenchmarkResult>()
+
+    fun <F> benchmark(
+        name: String,
+        opsPerIteration: Int,
+        setUp: () -> F,
+        tearDown: (F) -> Unit = {},
+        body: (F) -> Unit
+    ) {
+        if (filter != null && !name.contains(filter))
+            return
+
+        val fixture = setUp()
+        try {
+            repeat(warmup) { body(fixture) }
+
+            val samples = LongArray(iterations)
+            for (i in 0 until iterations) {
+                val start = getTimeNanos()
+                body(fixture)
+                samples[i] = getTimeNanos() - start
+            }
+
+            val result = BenchmarkResult(name, opsPerIteration, samples)
+            results.add(result)
+            println(result.summary())
+        } finally {
+            tearDown(fixture)
+        }
+    }
+}
+
+class BenchmarkResult(val name: String, val opsPerIteration: Int, samplesNanos: LongArray) {
+    private val sorted = samplesNanos.sortedArray()
+
+    val iterations: Int = sorted.size
+    val minNanos: Long = sorted.first()
+    val maxNanos: Long = sorted.last()
+    val meanNanos: Double = sorted.average()
+    val stdDevNanos: Double = if (sorted.size < 2) {
+        0.0
+    } else {
+        sqrt(sorted.sumOf { (it - meanNanos) * (it - meanNanos) } / (sorted.size - 1))
+    }
+    val p50Nanos: Long = percentile(0.5)
+    val p90Nanos: Long = percentile(0.9)
+
+    val opsPerSecond: Double
+        get() = opsPerIteration * 1_000_000_000.0 / meanNanos
+
+    private fun percentile(p: Double): Long = sorted[((sorted.size - 1) * p + 0.5).toInt()]
+
+    fun summary(): String =
+        "$name: ${formatMillis(meanNanos)} ms/iter ±${formatMillis(stdDevNanos)}, " +
+                "p50 ${formatMillis(p50Nanos.toDouble())}, p90 ${formatMillis(p90Nanos.toDouble())}, " +
+                "${opsPerSecond.toLong()} ops/s"
+
+    fun toJson(): String = buildString {
+        append("{")
+        append("\"name\":").append(jsonString(name)).append(",")
+        append("\"opsPerIteration\":").append(opsPerIteration).append(",")
+        append("\"iterations\":").append(iterations).append(",")
+        append("\"meanNanos\":").append(meanNanos.toLong()).append(",")
+        append("\"stdDevNanos\":").append(stdDevNanos.toLong()).append(",")
+        append("\"minNanos\":").append(minNanos).append(",")
+        append("\"p50Nanos\":").append(p50Nanos).append(",")
+        append("\"p90Nanos\":").append(p90Nanos).append(",")
+        append("\"maxNanos\":").append(maxNanos).append(",")
+        append("\"opsPerSecond\":").append(opsPerSecond.toLong())
+        append("}")
+    }
+
+    private fun formatMillis(nanos: Double): String {
+        val hundredths = (nanos / 10_000).toLong()
+        return "${hundredths / 100}.${(hundredths % 100).toString().padStart(2, '0')}"
+    }
+}
+
+internal fun jsonString(value: String): String = buildString {
+    append('"')
+    value.forEach { c ->
+        when {
+            c == '"' -> append("\\\"")
+            c == '\\' -> append("\\\\")
+            c < ' ' -> append("\\u").append(c.code.toString(16).padStart(4, '0'))
+            else -> append(c)
+        }
+    }
+    append('"')
+}
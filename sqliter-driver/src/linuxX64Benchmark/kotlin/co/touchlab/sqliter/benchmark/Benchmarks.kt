@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package co.touchlab.sqliter.benchmark
+
+import cnames.structs.sqlite3_stmt
+import co.touchlab.sqliter.*
+import co.touchlab.sqliter.sqlite3.SQLITE_OK
+import co.touchlab.sqliter.sqlite3.sqlite3_finalize
+import co.touchlab.sqliter.sqlite3.sqlite3_prepare16_v2
+import co.touchlab.sqliter.sqlite3.sqlite3_prepare_v3
+import kotlinx.cinterop.CPointerVar
+import kotlinx.cinterop.alloc
+import kotlinx.cinterop.cstr
+import kotlinx.cinterop.memScoped
+import kotlinx.cinterop.ptr
+import kotlinx.cinterop.value
+import kotlinx.cinterop.wcstr
+import kotlin.native.concurrent.TransferMode
+import kotlin.native.concurrent.Worker
+
+private const val TABLE = "CREATE TABLE test (num INTEGER NOT NULL, str TEXT NOT NULL)"
+private const val TEXT_TABLE = "CREATE TABLE text (a TEXT NOT NULL, b TEXT NOT NULL, c TEXT NOT NULL)"
+private const val BLOB_TABLE = "CREATE TABLE blobs (id INTEGER PRIMARY KEY, data BLOB NOT NULL)"
+private const val BLOB_SIZE = 64 * 1024
+
+/**
+ * Opens a fresh database named [name] in [dir] and runs [create] on it. Any existing file is deleted first.
+ */
+internal class BenchmarkDatabase(
+    val name: String,
+    val dir: String,
+    extended: DatabaseConfiguration.Extended = DatabaseConfiguration.Extended(),
+    create: (DatabaseConnection) -> Unit
+) {
+    init {
+        DatabaseFileContext.deleteDatabase(name, dir)
+    }
+
+    val manager = createDatabaseManager(
+        DatabaseConfiguration(
+            name = name,
+            version = 1,
+            create = create,
+            journalMode = JournalMode.WAL,
+            extendedConfig = extended.copy(basePath = dir),
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger)
+        )
+    )
+
+    val connection = manager.createMultiThreadedConnection()
+
+    fun close() {
+        connection.close()
+        DatabaseFileContext.deleteDatabase(name, dir)
+    }
+}
+
+private fun DatabaseConnection.fillTestTable(rows: Int) {
+    withStatement("insert into test(num, str)values(?,?)") {
+        executeBatch(rows) { i ->
+            bindLong(1, i.toLong())
+            bindString(2, "row $i")
+        }
+    }
+}
+
+private fun testTable(dir: String, rows: Int = 0, extended: DatabaseConfiguration.Extended = DatabaseConfiguration.Extended()) =
+    BenchmarkDatabase("sqliter-benchmark", dir, extended) { db ->
+        db.withStatement(TABLE) { execute() }
+        db.withStatement("CREATE INDEX test_num ON test(num)") { execute() }
+    }.also { it.connection.fillTestTable(rows) }
+
+fun BenchmarkRunner.runAll(dir: String) {
+    writes(dir)
+    reads(dir)
+    blobs(dir)
+    transactions(dir)
+    contention(dir)
+    connections(dir)
+}
+
+private fun BenchmarkRunner.writes(dir: String) {
+    benchmark("insertSingleRow", 200, { testTable(dir) }, { it.close() }) { db ->
+        db.connection.withStatement("insert into test(num, str)values(?,?)") {
+            for (i in 0 until 200) {
+                bindLong(1, i.toLong())
+                bindString(2, "row $i")
+                executeInsert()
+            }
+        }
+    }
+
+    benchmark("insertBatch", 10_000, { testTable(dir) }, { it.close() }) { db ->
+        db.connection.fillTestTable(10_000)
+    }
+
+    prepareStatement("prepareStatement") { testTable(dir) }
+    prepareStatement("prepareStatementCached") {
+        testTable(dir, extended = DatabaseConfiguration.Extended(statementCacheSize = 16))
+    }
+    prepareEncodings(dir)
+}
+
+private const val PREPARE_SQL = "select num, str from test where num = ? and str = ? limit 1"
+
+/**
+ * sqlite3_prepare16_v2 from a UTF-16 copy, as statements were compiled before, against sqlite3_prepare_v3 from a
+ * NUL-terminated UTF-8 copy, as SqliteDatabase.prepareStatement does now. Both finalize straight away.
+ */
+private fun BenchmarkRunner.prepareEncodings(dir: String) {
+    benchmark("prepareUtf16", 10_000, { testTable(dir) }, { it.close() }) { db ->
+        val dbPointer = db.connection.getDbPointer()
+        for (i in 0 until 10_000) {
+            memScoped {
+                val statementPtr = alloc<CPointerVar<sqlite3_stmt>>()
+                val sql = PREPARE_SQL.wcstr
+                check(sqlite3_prepare16_v2(dbPointer, sql.ptr, sql.size, statementPtr.ptr, null) == SQLITE_OK)
+                sqlite3_finalize(statementPtr.value)
+            }
+        }
+    }
+
+    benchmark("prepareUtf8", 10_000, { testTable(dir) }, { it.close() }) { db ->
+        val dbPointer = db.connection.getDbPointer()
+        for (i in 0 until 10_000) {
+            memScoped {
+                val statementPtr = alloc<CPointerVar<sqlite3_stmt>>()
+                val sql = PREPARE_SQL.cstr
+                check(sqlite3_prepare_v3(dbPointer, sql.ptr, sql.size, 0u, statementPtr.ptr, null) == SQLITE_OK)
+                sqlite3_finalize(statementPtr.value)
+            }
+        }
+    }
+}
+
+private fun BenchmarkRunner.prepareStatement(name: String, setUp: () -> BenchmarkDatabase) {
+    benchmark(name, 10_000, setUp, { it.close() }) { db ->
+        for (i in 0 until 10_000) {
+            db.connection.withStatement(PREPARE_SQL) {
+                bindLong(1, i.toLong())
+            }
+        }
+    }
+}
+
+private fun BenchmarkRunner.reads(dir: String) {
+    benchmark("pointLookup", 10_000, { testTable(dir, rows = 100_000) }, { it.close() }) { db ->
+        db.connection.withStatement("select str from test where num = ?") {
+            for (i in 0 until 10_000) {
+                bindLong(1, (i * 7L) % 100_000)
+                val cursor = query()
+                cursor.next()
+                cursor.getString(0)
+                resetStatement()
+            }
+        }
+    }
+
+    benchmark("rangeScan", 100_000, { testTable(dir, rows = 100_000) }, { it.close() }) { db ->
+        db.connection.withStatement("select num, str from test where num >= ? and num < ?") {
+            for (start in 0 until 100_000 step 1_000) {
+                bindLong(1, start.toLong())
+                bindLong(2, start + 1_000L)
+                val cursor = query()
+                while (cursor.next()) {
+                    cursor.getLong(0)
+                    cursor.getString(1)
+                }
+                resetStatement()
+            }
+        }
+    }
+
+    for (mode in listOf(ThreadingMode.MULTI_THREAD, ThreadingMode.SERIALIZED)) {
+        val extended = DatabaseConfiguration.Extended(threadingMode = mode)
+        benchmark("fullScan_${mode.name}", 100_000, { testTable(dir, 100_000, extended) }, { it.close() }) { db ->
+            db.connection.withStatement("select num, str from test") {
+                val cursor = query()
+                while (cursor.next()) {
+                    cursor.getLong(0)
+                    cursor.getString(1)
+                }
+            }
+        }
+    }
+
+    //Schema-less row reading, where the type of each cell decides how to read it
+    benchmark("typeDecode", 100_000, { testTable(dir, rows = 100_000) }, { it.close() }) { db ->
+        db.connection.withStatement("select num, str from test") {
+            val cursor = query()
+            val columns = cursor.columnCount
+            while (cursor.next()) {
+                for (i in 0 until columns) {
+                    readCell(cursor, i, cursor.getType(i))
+                }
+            }
+        }
+    }
+
+    benchmark("typeDecodeBulk", 100_000, { testTable(dir, rows = 100_000) }, { it.close() }) { db ->
+        db.connection.withStatement("select num, str from test") {
+            val cursor = query()
+            val types = IntArray(cursor.columnCount)
+            while (cursor.next()) {
+                cursor.getTypes(types)
+                for (i in types.indices) {
+                    readCell(cursor, i, FieldType.forCode(types[i]))
+                }
+            }
+        }
+    }
+
+    benchmark("stringReads", 10_000, {
+        BenchmarkDatabase("sqliter-benchmark", dir) { db ->
+            db.withStatement(TEXT_TABLE) { execute() }
+        }.also { db ->
+            val long = "x".repeat(200)
+            db.connection.withStatement("insert into text(a, b, c)values(?,?,?)") {
+                executeBatch(10_000) { i ->
+                    bindString(1, "$i $long")
+                    bindString(2, "$long $i")
+                    bindString(3, "ünïcödé $i $long")
+                }
+            }
+        }
+    }, { it.close() }) { db ->
+        db.connection.withStatement("select a, b, c from text") {
+            val cursor = query()
+            while (cursor.next()) {
+                cursor.getString(0)
+                cursor.getString(1)
+                cursor.getString(2)
+            }
+        }
+    }
+}
+
+private fun readCell(cursor: Cursor, index: Int, type: FieldType) {
+    when (type) {
+        FieldType.TYPE_INTEGER -> cursor.getLong(index)
+        FieldType.TYPE_FLOAT -> cursor.getDouble(index)
+        FieldType.TYPE_TEXT -> cursor.withText(index) { _, size -> size }
+        FieldType.TYPE_BLOB -> cursor.withBlob(index) { _, size -> size }
+        FieldType.TYPE_NULL -> {}
+    }
+}
+
+private fun BenchmarkRunner.blobs(dir: String) {
+    val blob = ByteArray(BLOB_SIZE) { it.toByte() }
+    val blobDatabase = {
+        BenchmarkDatabase("sqliter-benchmark", dir) { db ->
+            db.withStatement(BLOB_TABLE) { execute() }
+        }.also { db ->
+            db.connection.withStatement("insert into blobs(id, data)values(?,?)") {
+                executeBatch(100) { i ->
+                    bindLong(1, i.toLong())
+                    bindBlob(2, blob)
+                }
+            }
+        }
+    }
+
+    benchmark("blobWrite", 100, blobDatabase, { it.close() }) { db ->
+        db.connection.withStatement("update blobs set data = ? where id = ?") {
+            executeBatch(100) { i ->
+                bindBlob(1, blob)
+                bindLong(2, i.toLong())
+            }
+        }
+    }
+
+    benchmark("blobRead", 100, blobDatabase, { it.close() }) { db ->
+        db.connection.withStatement("select data from blobs") {
+            val cursor = query()
+            while (cursor.next()) {
+                cursor.getBytes(0)
+            }
+        }
+    }
+
+    benchmark("blobReadInto", 100, blobDatabase, { it.close() }) { db ->
+        val dest = ByteArray(BLOB_SIZE)
+        db.connection.withStatement("select data from blobs") {
+            val cursor = query()
+            while (cursor.next()) {
+                cursor.getBytesInto(0, dest)
+            }
+        }
+    }
+
+    benchmark("blobStreamRead", 100, blobDatabase, { it.close() }) { db ->
+        val chunk = ByteArray(4096)
+        db.connection.withBlob("blobs", "data", 0) {
+            for (row in 0L until 100L) {
+                reopen(row)
+                for (offset in 0 until size step chunk.size) {
+                    read(offset, chunk)
+                }
+            }
+        }
+    }
+}
+
+private fun BenchmarkRunner.transactions(dir: String) {
+    //BEGIN and COMMIT prepared for every transaction, as beginTransaction did before they were cached
+    benchmark("transactionThroughputUncached", 2_000, { testTable(dir) }, { it.close() }) { db ->
+        db.connection.withStatement("insert into test(num, str)values(?,?)") {
+            for (i in 0 until 2_000) {
+                db.connection.rawExecSql("BEGIN")
+                bindLong(1, i.toLong())
+                bindString(2, "row $i")
+                executeInsert()
+                db.connection.rawExecSql("COMMIT")
+            }
+        }
+    }
+
+    benchmark("transactionThroughput", 2_000, { testTable(dir) }, { it.close() }) { db ->
+        db.connection.withStatement("insert into test(num, str)values(?,?)") {
+            for (i in 0 until 2_000) {
+                db.connection.withTransaction {
+                    bindLong(1, i.toLong())
+                    bindString(2, "row $i")
+                    executeInsert()
+                }
+            }
+        }
+    }
+
+    benchmark("transactionNested", 2_000, { testTable(dir) }, { it.close() }) { db ->
+        db.connection.withTransaction { conn ->
+            conn.withStatement("insert into test(num, str)values(?,?)") {
+                for (i in 0 until 2_000) {
+                    conn.withTransaction {
+                        bindLong(1, i.toLong())
+                        bindString(2, "row $i")
+                        executeInsert()
+                    }
+                }
+            }
+        }
+    }
+}
+
+private const val THREADS = 8
+private const val OPS_PER_THREAD = 250
+
+/**
+ * Workers plus a shared [target] to run operations against. [target] is opened in setup and closed in teardown,
+ * so neither is part of the timed iterations.
+ */
+internal class ContentionFixture<T>(
+    val db: BenchmarkDatabase,
+    open: (BenchmarkDatabase) -> T,
+    private val closeTarget: (T) -> Unit = {}
+) {
+    val workers = Array(THREADS) { Worker.start() }
+    val target = open(db)
+
+    /**
+     * Runs [op] OPS_PER_THREAD times on each worker, and waits for all of them.
+     */
+    fun runOnAll(op: (Int) -> Unit) {
+        runOnEach { _, i -> op(i) }
+    }
+
+    /**
+     * Like [runOnAll], but [op] also gets the index of the worker it runs on.
+     */
+    fun runOnEach(op: (Int, Int) -> Unit) {
+        workers.mapIndexed { index, worker ->
+            worker.execute(TransferMode.SAFE, { index to op }) { (workerIndex, job) ->
+                for (i in 0 until OPS_PER_THREAD) {
+                    job(workerIndex, i)
+                }
+            }
+        }.forEach { it.result }
+    }
+
+    fun close() {
+        workers.forEach { it.requestTermination().result }
+        closeTarget(target)
+        db.close()
+    }
+}
+
+private fun DatabaseConnection.insertRow(i: Int) {
+    withStatement("insert into test(num, str)values(?,?)") {
+        bindLong(1, i.toLong())
+        bindString(2, "row $i")
+        executeInsert()
+    }
+}
+
+private fun BenchmarkRunner.contention(dir: String) {
+    benchmark("contendedConnection", THREADS * OPS_PER_THREAD, {
+        ContentionFixture(testTable(dir, rows = 10_000), { it.connection })
+    }, { it.close() }) { fixture ->
+        val connection = fixture.target
+        fixture.runOnAll { i ->
+            if (i % 4 == 0) {
+                connection.insertRow(i)
+            } else {
+                connection.withStatement("select str from test where num = ?") {
+                    bindLong(1, i.toLong())
+                    val cursor = query()
+                    cursor.next()
+                }
+            }
+        }
+    }
+
+    benchmark("contendedPool", THREADS * OPS_PER_THREAD, {
+        ContentionFixture(testTable(dir, rows = 10_000), { it.manager.createConnectionPool() }, { it.close() })
+    }, { it.close() }) { fixture ->
+        val pool = fixture.target
+        fixture.runOnAll { i ->
+            if (i % 4 == 0) {
+                pool.write { conn -> conn.rawExecSql("insert into test(num, str)values($i, 'row $i')") }
+            } else {
+                pool.read { conn -> conn.longForQuery("select num from test where num = $i") }
+            }
+        }
+    }
+
+    //Baseline for contendedWriteQueue: every caller commits its own transaction on its own connection
+    benchmark("contendedTransactionPerCaller", THREADS * OPS_PER_THREAD, {
+        ContentionFixture(testTable(dir), { db ->
+            Array(THREADS) { db.manager.createMultiThreadedConnection() }
+        }, { connections -> connections.forEach { it.close() } })
+    }, { it.close() }) { fixture ->
+        val connections = fixture.target
+        fixture.runOnEach { worker, i ->
+            connections[worker].withTransaction(TransactionMode.IMMEDIATE) { conn -> conn.insertRow(i) }
+        }
+    }
+
+    benchmark("contendedWriteQueue", THREADS * OPS_PER_THREAD, {
+        ContentionFixture(testTable(dir), { it.manager.createWriteQueue() }, { it.close() })
+    }, { it.close() }) { fixture ->
+        val queue = fixture.target
+        fixture.runOnAll { i ->
+            queue.write { conn -> conn.insertRow(i) }
+        }
+    }
+}
+
+private fun BenchmarkRunner.connections(dir: String) {
+    benchmark("connectionOpen", 50, { testTable(dir) }, { it.close() }) { db ->
+        for (i in 0 until 50) {
+            db.manager.createSingleThreadedConnection().close()
+        }
+    }
+}
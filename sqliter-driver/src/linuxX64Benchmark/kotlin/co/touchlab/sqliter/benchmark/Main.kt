@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package co.touchlab.sqliter.benchmark
+
+import co.touchlab.sqliter.stringForQuery
+import platform.posix.fclose
+import platform.posix.fopen
+import platform.posix.fputs
+
+/**
+ * Options, all optional:
+ *
+ * --out=path        JSON results file. Defaults to benchmark-results.json
+ * --dir=path        Directory for the benchmark databases. Defaults to /tmp
+ * --filter=text     Only run benchmarks whose name contains text
+ * --warmup=n        Untimed iterations per benchmark. Defaults to 3
+ * --iterations=n    Timed iterations per benchmark. Defaults to 10
+ */
+fun main(args: Array<String>) {
+    val options = args.associate { arg ->
+        val parts = arg.removePrefix("--").split("=", limit = 2)
+        parts[0] to parts.getOrElse(1) { "" }
+    }
+
+    val out = options["out"] ?: "benchmark-results.json"
+    val dir = options["dir"] ?: "/tmp"
+    val warmup = options["warmup"]?.toInt() ?: 3
+    val iterations = options["iterations"]?.toInt() ?: 10
+    require(warmup >= 0) { "--warmup cannot be negative" }
+    require(iterations >= 1) { "--iterations must be at least 1" }
+
+    val runner = BenchmarkRunner(warmup, iterations, options["filter"])
+    runner.runAll(dir)
+
+    val sqliteVersion = BenchmarkDatabase("sqliter-benchmark-version", dir) { }.let { db ->
+        try {
+            db.connection.stringForQuery("select sqlite_version()")
+        } finally {
+            db.close()
+        }
+    }
+
+    val json = buildString {
+        append("{")
+        append("\"sqliteVersion\":").append(jsonString(sqliteVersion)).append(",")
+        append("\"warmup\":").append(warmup).append(",")
+        append("\"iterations\":").append(iterations).append(",")
+        append("\"benchmarks\":[")
+        runner.results.forEachIndexed { index, result ->
+            if (index > 0)
+                append(",")
+            append(result.toJson())
+        }
+        append("]}\n")
+    }
+
+    val file = fopen(out, "w") ?: throw IllegalStateException("Cannot open $out")
+    try {
+        fputs(json, file)
+    } finally {
+        fclose(file)
+    }
+    println("Wrote ${runner.results.size} results to $out")
+}
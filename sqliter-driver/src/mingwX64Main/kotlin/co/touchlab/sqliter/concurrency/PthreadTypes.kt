@@ -0,0 +1,8 @@
+package co.touchlab.sqliter.concurrency
+
+import platform.posix.pthread_cond_tVar
+import platform.posix.pthread_mutex_tVar
+
+//Variable types for the shared pthread Condition. On mingw the handles are integers, so these are the Var wrappers.
+internal typealias PthreadMutexVar = pthread_mutex_tVar
+internal typealias PthreadCondVar = pthread_cond_tVar
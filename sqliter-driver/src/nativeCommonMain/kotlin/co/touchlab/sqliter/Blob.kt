@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package co.touchlab.sqliter
+
+/**
+ * Handle for incremental I/O on a single blob value, from DatabaseConnection.openBlob. Reads and writes go
+ * straight to the database in chunks, so large values can be streamed without holding them in memory.
+ *
+ * The blob's size is fixed. Writes can't grow it, so preallocate space with Statement.bindZeroBlob or
+ * zeroblob(N) in SQL. If the row is changed by anything other than this handle, the handle expires and further
+ * calls throw. Call close when done.
+ */
+interface Blob {
+    val size: Int
+    val writable: Boolean
+
+    /**
+     * Reads [length] bytes starting at [offset] in the blob into [buffer] at [bufferOffset].
+     */
+    fun read(offset: Int, buffer: ByteArray, bufferOffset: Int = 0, length: Int = buffer.size - bufferOffset)
+
+    /**
+     * Writes [length] bytes from [buffer] at [bufferOffset] to the blob, starting at [offset].
+     */
+    fun write(offset: Int, buffer: ByteArray, bufferOffset: Int = 0, length: Int = buffer.size - bufferOffset)
+
+    /**
+     * Points this handle at the same column in a different row. Cheaper than closing and opening a new handle.
+     */
+    fun reopen(rowId: Long)
+
+    fun close()
+}
+
+fun <R> DatabaseConnection.withBlob(
+    table: String,
+    column: String,
+    rowId: Long,
+    writable: Boolean = false,
+    proc: Blob.() -> R
+): R {
+    val blob = openBlob(table, column, rowId, writable)
+    try {
+        return blob.proc()
+    } finally {
+        blob.close()
+    }
+}
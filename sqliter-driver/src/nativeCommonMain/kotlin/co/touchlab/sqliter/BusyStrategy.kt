@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+import kotlin.concurrent.AtomicLong
+import kotlin.random.Random
+
+/**
+ * What a statement step does when sqlite3_step returns SQLITE_BUSY or SQLITE_LOCKED. This covers every step, so
+ * cursor reads as well as execute, executeInsert and executeUpdateDelete. It happens after sqlite's own busy
+ * handler, configured with DatabaseConfiguration.Extended.busyTimeout, has given up.
+ */
+sealed class BusyStrategy {
+    /**
+     * Microseconds to wait before the next attempt, or -1 to give up. [attempt] starts at 0.
+     */
+    internal abstract fun nextDelayMicros(attempt: Int, waitedNanos: Long): Long
+
+    /**
+     * Don't retry. Rely on the sqlite busy handler alone.
+     */
+    object SqliteBusyHandler : BusyStrategy() {
+        override fun nextDelayMicros(attempt: Int, waitedNanos: Long): Long = -1
+    }
+
+    /**
+     * Retry up to [maxRetries] times, waiting [delayMicros] (less than a second) each time.
+     */
+    data class FixedDelay(val maxRetries: Int = 50, val delayMicros: Long = 1000) : BusyStrategy() {
+        init {
+            require(maxRetries >= 0) { "maxRetries cannot be negative" }
+            require(delayMicros in 0 until MAX_DELAY_MICROS) { "delayMicros must be between 0 and 999999" }
+        }
+
+        override fun nextDelayMicros(attempt: Int, waitedNanos: Long): Long =
+            if (attempt < maxRetries) delayMicros else -1
+    }
+
+    /**
+     * Retry with a delay that doubles each time, from [initialDelayMicros] up to [maxDelayMicros] (less than a
+     * second), until [timeoutMillis] has been spent waiting in total. With [jitter], each delay is randomized
+     * between half and all of its nominal value, so contending threads don't retry in lockstep.
+     */
+    data class ExponentialBackoff(
+        val initialDelayMicros: Long = 250,
+        val maxDelayMicros: Long = 50_000,
+        val timeoutMillis: Long = 5_000,
+        val jitter: Boolean = true
+    ) : BusyStrategy() {
+        init {
+            require(initialDelayMicros > 0) { "initialDelayMicros must be positive" }
+            require(maxDelayMicros >= initialDelayMicros) { "maxDelayMicros must be at least initialDelayMicros" }
+            require(maxDelayMicros < MAX_DELAY_MICROS) { "maxDelayMicros must be less than a second" }
+        }
+
+        override fun nextDelayMicros(attempt: Int, waitedNanos: Long): Long {
+            val remainingMicros = timeoutMillis * 1000 - waitedNanos / 1000
+            if (remainingMicros <= 0)
+                return -1
+
+            //Stops doubling once past maxDelayMicros, so the shift can't overflow
+            val shift = minOf(attempt, 62)
+            val nominal = if (initialDelayMicros > maxDelayMicros shr shift) {
+                maxDelayMicros
+            } else {
+                minOf(maxDelayMicros, initialDelayMicros shl shift)
+            }
+            val delay = if (jitter) nominal / 2 + Random.nextLong(nominal / 2 + 1) else nominal
+            return minOf(delay, remainingMicros)
+        }
+    }
+}
+
+//usleep only accepts values below a second
+private const val MAX_DELAY_MICROS = 1_000_000L
+
+/**
+ * Busy retry totals across all connections from a manager.
+ */
+data class BusyStats(
+    val retries: Long,
+    val waitNanos: Long,
+    val failures: Long
+)
+
+internal class BusyCounters {
+    private val retries = AtomicLong(0)
+    private val waitNanos = AtomicLong(0)
+    private val failures = AtomicLong(0)
+
+    fun retried(waited: Long) {
+        retries.incrementAndGet()
+        waitNanos.addAndGet(waited)
+    }
+
+    fun failed() {
+        failures.incrementAndGet()
+    }
+
+    fun snapshot(): BusyStats = BusyStats(retries.value, waitNanos.value, failures.value)
+}
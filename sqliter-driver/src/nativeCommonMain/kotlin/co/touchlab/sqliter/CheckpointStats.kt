@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * Background checkpoint totals, from DatabaseManager.checkpointStats. See
+ * DatabaseConfiguration.Extended.backgroundCheckpoint.
+ *
+ * [walPages] is the WAL size reported by the most recent commit, and [maxWalPages] the largest seen. [busy] counts
+ * RESTART and TRUNCATE checkpoints that couldn't finish because of active readers or writers.
+ */
+data class CheckpointStats(
+    val passive: Long,
+    val restart: Long,
+    val truncate: Long,
+    val busy: Long,
+    val failures: Long,
+    val walPages: Int,
+    val maxWalPages: Int,
+    val totalNanos: Long,
+    val maxNanos: Long
+) {
+    val checkpoints: Long
+        get() = passive + restart + truncate
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * Reusable column-oriented buffer for Cursor.fetchColumns. Each result column is read as the FieldType given
+ * in [columnTypes], with the same coercion rules as the single value Cursor getters. TYPE_INTEGER columns fill a
+ * LongArray, TYPE_FLOAT a DoubleArray, TYPE_TEXT an Array<String?> and TYPE_BLOB an Array<ByteArray?>. Nulls are
+ * tracked in a per-column bitmap.
+ *
+ * The same chunk can be passed to fetchColumns repeatedly. Each call overwrites the previous contents.
+ */
+class ColumnChunk(val columnTypes: Array<FieldType>, val capacity: Int) {
+    init {
+        require(capacity > 0) { "capacity must be positive" }
+        require(columnTypes.none { it == FieldType.TYPE_NULL }) { "TYPE_NULL is not a valid column type" }
+    }
+
+    var rowCount: Int = 0
+        private set
+
+    private val longs = Array(columnTypes.size) { if (columnTypes[it] == FieldType.TYPE_INTEGER) LongArray(capacity) else null }
+    private val doubles = Array(columnTypes.size) { if (columnTypes[it] == FieldType.TYPE_FLOAT) DoubleArray(capacity) else null }
+    private val strings = Array(columnTypes.size) { if (columnTypes[it] == FieldType.TYPE_TEXT) arrayOfNulls<String>(capacity) else null }
+    private val blobs = Array(columnTypes.size) { if (columnTypes[it] == FieldType.TYPE_BLOB) arrayOfNulls<ByteArray>(capacity) else null }
+    private val nulls = Array(columnTypes.size) { LongArray((capacity + 63) / 64) }
+
+    val columnCount: Int
+        get() = columnTypes.size
+
+    fun longs(column: Int): LongArray = longs[column] ?: throw wrongType(column, FieldType.TYPE_INTEGER)
+    fun doubles(column: Int): DoubleArray = doubles[column] ?: throw wrongType(column, FieldType.TYPE_FLOAT)
+    fun strings(column: Int): Array<String?> = strings[column] ?: throw wrongType(column, FieldType.TYPE_TEXT)
+    fun blobs(column: Int): Array<ByteArray?> = blobs[column] ?: throw wrongType(column, FieldType.TYPE_BLOB)
+
+    fun isNull(column: Int, row: Int): Boolean = (nulls[column][row ushr 6] and (1L shl row)) != 0L
+
+    /**
+     * The raw null bitmap for a column. Bit (row % 64) of word (row / 64) is set if the value is null.
+     */
+    fun nullBitmap(column: Int): LongArray = nulls[column]
+
+    internal fun clear() {
+        rowCount = 0
+        nulls.forEach { it.fill(0L) }
+    }
+
+    internal fun setNull(column: Int, row: Int) {
+        val bitmap = nulls[column]
+        bitmap[row ushr 6] = bitmap[row ushr 6] or (1L shl row)
+        strings[column]?.set(row, null)
+        blobs[column]?.set(row, null)
+    }
+
+    internal fun setLong(column: Int, row: Int, value: Long) {
+        longs[column]!![row] = value
+    }
+
+    internal fun setDouble(column: Int, row: Int, value: Double) {
+        doubles[column]!![row] = value
+    }
+
+    internal fun setString(column: Int, row: Int, value: String) {
+        strings[column]!![row] = value
+    }
+
+    internal fun setBlob(column: Int, row: Int, value: ByteArray) {
+        blobs[column]!![row] = value
+    }
+
+    internal fun endRow() {
+        rowCount++
+    }
+
+    private fun wrongType(column: Int, requested: FieldType) =
+        IllegalArgumentException("Column $column is ${columnTypes[column]}, not $requested")
+}
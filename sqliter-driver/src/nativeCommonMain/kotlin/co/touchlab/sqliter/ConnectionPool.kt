@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * One writer connection plus a set of read-only connections. With JournalMode.WAL, readers don't block each other
+ * or the writer, so reads scale across threads.
+ *
+ * Connections passed to [read] and [write] belong to the calling thread for the duration of the block only. Don't
+ * keep them, or statements and cursors created from them, after the block returns.
+ *
+ * Waiting callers are served in the order they arrived.
+ */
+interface ConnectionPool {
+    /**
+     * Runs [block] with one of the read-only connections. For in-memory and temporary databases, which can't be
+     * shared across connections, this uses the writer connection.
+     */
+    fun <R> read(block: (DatabaseConnection) -> R): R
+
+    /**
+     * Runs [block] with the single writer connection.
+     */
+    fun <R> write(block: (DatabaseConnection) -> R): R
+
+    /**
+     * Closes idle connections. Connections in use are closed when their block returns. Calls after close fail.
+     */
+    fun close()
+}
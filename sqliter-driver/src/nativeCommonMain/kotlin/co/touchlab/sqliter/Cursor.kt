@@ -16,8 +16,16 @@
 
 package co.touchlab.sqliter
 
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.addressOf
+import kotlinx.cinterop.usePinned
+
 /**
  * Simplified Cursor implementation. Forward-only traversal.
+ *
+ * Members added after the first release have defaults, built on the older members, so existing implementations keep
+ * compiling. They copy values that the native cursor reads in place.
  */
 interface Cursor {
     fun next(): Boolean
@@ -26,25 +34,102 @@ interface Cursor {
     fun getLong(index: Int): Long
     fun getBytes(index: Int): ByteArray
     fun getDouble(index: Int): Double
+
+    /**
+     * Calls [block] with a pointer to the blob in sqlite's memory, without copying it. The pointer is only valid
+     * inside [block]. It's null, with size 0, for null or empty values.
+     */
+    fun <R> withBlob(index: Int, block: (bytes: CPointer<ByteVar>?, size: Int) -> R): R =
+        withPinned(if (isNull(index)) null else getBytes(index), block)
+
+    /**
+     * Like [withBlob], for the value as UTF-8 text. [size] is in bytes and excludes the terminator.
+     */
+    fun <R> withText(index: Int, block: (utf8: CPointer<ByteVar>?, size: Int) -> R): R =
+        withPinned(if (isNull(index)) null else getString(index).encodeToByteArray(), block)
+
+    /**
+     * Copies the blob into [dest] at [offset], and returns the blob's size. If the blob is bigger than the space
+     * in [dest], only the bytes that fit are copied. Throws IndexOutOfBoundsException if [offset] isn't within
+     * 0..dest.size.
+     */
+    fun getBytesInto(index: Int, dest: ByteArray, offset: Int = 0): Int {
+        if (offset < 0 || offset > dest.size)
+            throw IndexOutOfBoundsException("offset $offset is outside dest of size ${dest.size}")
+        val bytes = if (isNull(index)) ByteArray(0) else getBytes(index)
+        bytes.copyInto(dest, offset, 0, minOf(bytes.size, dest.size - offset))
+        return bytes.size
+    }
     fun getType(index: Int):FieldType
+
+    /**
+     * Fills [types] with the FieldType.nativeCode of each column in the current row, for the first types.size
+     * columns. Decode with FieldType.forCode. Returns the number of columns filled.
+     */
+    fun getTypes(types: IntArray): Int {
+        val count = minOf(types.size, columnCount)
+        for (i in 0 until count) {
+            types[i] = getType(i).nativeCode
+        }
+        return count
+    }
     val columnCount: Int
     fun columnName(index: Int): String
     val columnNames: Map<String, Int>
     val statement:Statement
+
+    /**
+     * Steps through up to chunk.capacity rows, starting with the row the next call to next() would move to, and
+     * copies the first chunk.columnCount columns into [chunk]. Returns the number of rows read. A result smaller
+     * than the capacity means the cursor is exhausted.
+     */
+    fun fetchColumns(chunk: ColumnChunk): Int {
+        val types = chunk.columnTypes
+        if (types.size > columnCount)
+            throw IllegalArgumentException("Chunk has ${types.size} columns, query has $columnCount")
+
+        chunk.clear()
+        while (chunk.rowCount < chunk.capacity && next()) {
+            val row = chunk.rowCount
+            for (col in types.indices) {
+                if (isNull(col)) {
+                    chunk.setNull(col, row)
+                } else {
+                    when (types[col]) {
+                        FieldType.TYPE_INTEGER -> chunk.setLong(col, row, getLong(col))
+                        FieldType.TYPE_FLOAT -> chunk.setDouble(col, row, getDouble(col))
+                        FieldType.TYPE_TEXT -> chunk.setString(col, row, getString(col))
+                        FieldType.TYPE_BLOB -> chunk.setBlob(col, row, getBytes(col))
+                        FieldType.TYPE_NULL -> chunk.setNull(col, row)
+                    }
+                }
+            }
+            chunk.endRow()
+        }
+        return chunk.rowCount
+    }
 }
 
+//For the withBlob and withText defaults. Like the native cursor, null and empty values are a null pointer.
+private inline fun <R> withPinned(bytes: ByteArray?, block: (CPointer<ByteVar>?, Int) -> R): R =
+    if (bytes == null || bytes.isEmpty()) {
+        block(null, 0)
+    } else {
+        bytes.usePinned { block(it.addressOf(0), bytes.size) }
+    }
+
 enum class FieldType(val nativeCode: Int) {
     //These names a prefixed with 'TYPE_' to avoid Kotlin/Native to Swift name collisions
     TYPE_INTEGER(1), TYPE_FLOAT(2), TYPE_BLOB(4), TYPE_NULL(5), TYPE_TEXT(3);
 
     companion object {
-        fun forCode(nativeCode: Int):FieldType{
-            FieldType.values().forEach {
-                if(it.nativeCode == nativeCode)
-                    return it
-            }
-            throw IllegalArgumentException("Native code not found $nativeCode")
+        //Indexed by native code, which sqlite keeps in 1..5
+        private val byCode = arrayOfNulls<FieldType>(6).also { table ->
+            values().forEach { table[it.nativeCode] = it }
         }
+
+        fun forCode(nativeCode: Int):FieldType =
+            byCode.getOrNull(nativeCode) ?: throw IllegalArgumentException("Native code not found $nativeCode")
     }
 }
 
@@ -83,5 +168,63 @@ fun Cursor.forLong():Long{
     return result
 }
 
+fun Cursor.fetchColumns(maxRows: Int, vararg columnTypes: FieldType): ColumnChunk {
+    val chunk = ColumnChunk(arrayOf(*columnTypes), maxRows)
+    fetchColumns(chunk)
+    return chunk
+}
+
 fun Cursor.getColumnIndexOrThrow(name:String):Int = columnNames[name] ?: throw IllegalArgumentException("Col for $name not found")
 
+/**
+ * Resolves [names] to column indexes, in the same order.
+ */
+fun Cursor.getColumnIndexes(vararg names: String): IntArray {
+    val map = columnNames
+    return IntArray(names.size) { map[names[it]] ?: throw IllegalArgumentException("Col for ${names[it]} not found") }
+}
+
+/**
+ * Maps each remaining row with [mapper]. [columnNames] are looked up once, on the first row, and passed to [mapper]
+ * as indexes in the same order, so reading a row doesn't hash any names. Looking up on the first row, rather than
+ * before it, picks up column changes from a statement sqlite recompiled after a schema change.
+ *
+ * ```
+ * val users = cursor.mapRows("id", "name") { c, col -> User(c.getLong(col[0]), c.getString(col[1])) }
+ * ```
+ */
+inline fun <T> Cursor.mapRows(vararg columnNames: String, mapper: (cursor: Cursor, columns: IntArray) -> T): List<T> {
+    val result = ArrayList<T>()
+    if (!next())
+        return result
+    val columns = getColumnIndexes(*columnNames)
+    do {
+        result.add(mapper(this, columns))
+    } while (next())
+    return result
+}
+
+/**
+ * Like [mapRows], but rows are read and mapped as the sequence is iterated. The sequence can only be iterated once.
+ */
+fun <T> Cursor.rowSequence(vararg columnNames: String, mapper: (cursor: Cursor, columns: IntArray) -> T): Sequence<T> {
+    val cursor = this
+    return Sequence {
+        object : Iterator<T> {
+            private var hasRow: Boolean? = null
+            private var columns: IntArray? = null
+
+            override fun hasNext(): Boolean =
+                hasRow ?: cursor.next().also { hasRow = it }
+
+            override fun next(): T {
+                if (!hasNext())
+                    throw NoSuchElementException()
+                hasRow = null
+                val indexes = columns ?: cursor.getColumnIndexes(*columnNames).also { columns = it }
+                return mapper(cursor, indexes)
+            }
+        }
+    }.constrainOnce()
+}
+
@@ -17,6 +17,7 @@
 package co.touchlab.sqliter
 
 import co.touchlab.sqliter.interop.Logger
+import co.touchlab.sqliter.interop.SqlTraceListener
 
 /**
  * The database manager will skip version checks, create, and update when this is set. This is useful if you
@@ -54,10 +55,28 @@ data class DatabaseConfiguration(
         val recursiveTriggers: Boolean = false,
         val lookasideSlotSize: Int = -1,
         val lookasideSlotCount: Int = -1,
+        val statementCacheSize: Int = 0,
+        val readerConnectionCount: Int = 4,
+        val busyStrategy: BusyStrategy = BusyStrategy.FixedDelay(),
+        val threadingMode: ThreadingMode = ThreadingMode.MULTI_THREAD,
+        val writeQueueMaxBatch: Int = 256,
+        val writeQueueMaxDelayMillis: Long = 0,
+        val transactionMode: TransactionMode = TransactionMode.DEFERRED,
+        val mmapSize: Long? = null,
+        val cacheSize: Int? = null,
+        val tempStore: TempStore? = null,
+        val walAutoCheckpoint: Int? = null,
+        val backgroundCheckpoint: Boolean = false,
+        val functions: List<SqlFunction> = emptyList(),
     )
     data class Logging(
         val logger: Logger = WarningLogger,
-        val verboseDataCalls: Boolean = false
+        val verboseDataCalls: Boolean = false,
+        val enableTrace: Boolean = false,
+        val enableProfile: Boolean = false,
+        val traceListener: SqlTraceListener? = null,
+        val statementMetrics: Boolean = false,
+        val slowStatementThresholdMs: Long = -1,
     )
     data class Lifecycle(
         val onCreateConnection: (DatabaseConnection) -> Unit = { _ -> },
@@ -69,6 +88,20 @@ data class DatabaseConfiguration(
     )
     init {
         checkFilename(name)
+        require(extendedConfig.statementCacheSize >= 0) { "statementCacheSize cannot be negative" }
+        require(extendedConfig.readerConnectionCount >= 0) { "readerConnectionCount cannot be negative" }
+        require(extendedConfig.writeQueueMaxBatch > 0) { "writeQueueMaxBatch must be positive" }
+        require(extendedConfig.writeQueueMaxDelayMillis >= 0) { "writeQueueMaxDelayMillis cannot be negative" }
+        extendedConfig.pageSize?.let { pageSize ->
+            require(pageSize in 512..65536 && (pageSize and (pageSize - 1)) == 0) {
+                "pageSize must be a power of two between 512 and 65536"
+            }
+        }
+        require((extendedConfig.mmapSize ?: 0) >= 0) { "mmapSize cannot be negative" }
+        require((extendedConfig.walAutoCheckpoint ?: 0) >= 0) { "walAutoCheckpoint cannot be negative" }
+        require(!extendedConfig.backgroundCheckpoint || extendedConfig.walAutoCheckpoint != 0) {
+            "backgroundCheckpoint needs a walAutoCheckpoint threshold above 0"
+        }
     }
 }
 
@@ -125,6 +158,50 @@ enum class JournalMode {
     }
 }
 
+/**
+ * sqlite threading mode for each connection. See https://www.sqlite.org/threadsafe.html
+ */
+enum class ThreadingMode {
+    /**
+     * SQLITE_OPEN_NOMUTEX, the default. SQLiter already serializes access to each connection.
+     */
+    MULTI_THREAD,
+
+    /**
+     * SQLITE_OPEN_FULLMUTEX. Only needed if you use the connection pointer from getDbPointer() on other threads.
+     */
+    SERIALIZED
+}
+
+/**
+ * How a top level transaction takes its locks. See https://www.sqlite.org/lang_transaction.html
+ */
+enum class TransactionMode(internal val beginSql: String) {
+    /**
+     * BEGIN DEFERRED. Locks are taken on first read or write. Two of these that read and then write can deadlock,
+     * and one fails with SQLITE_BUSY part way through.
+     */
+    DEFERRED("BEGIN;"),
+
+    /**
+     * BEGIN IMMEDIATE. Takes the write lock up front, so writers wait for each other at BEGIN, where the busy
+     * handler applies. Readers aren't blocked in WAL mode.
+     */
+    IMMEDIATE("BEGIN IMMEDIATE;"),
+
+    /**
+     * BEGIN EXCLUSIVE. Like IMMEDIATE, and in rollback journal modes also keeps readers out.
+     */
+    EXCLUSIVE("BEGIN EXCLUSIVE;")
+}
+
+/**
+ * Where temporary tables and indices are kept. See https://www.sqlite.org/pragma.html#pragma_temp_store
+ */
+enum class TempStore(val value: Int) {
+    DEFAULT(0), FILE(1), MEMORY(2);
+}
+
 enum class SynchronousFlag(val value: Int) {
     OFF(0), NORMAL(1), FULL(2), EXTRA(3);
 }
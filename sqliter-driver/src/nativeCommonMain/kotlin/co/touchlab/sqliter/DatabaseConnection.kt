@@ -18,15 +18,79 @@ package co.touchlab.sqliter
 
 import co.touchlab.sqliter.interop.SqliteDatabasePointer
 
+/**
+ * Members added after the first release have defaults, so existing implementations keep compiling. Defaults fall
+ * back to the older members where they can, and throw UnsupportedOperationException where they can't.
+ */
 interface DatabaseConnection {
     fun rawExecSql(sql: String)
     fun createStatement(sql: String): Statement
     fun beginTransaction()
+
+    /**
+     * Starts a transaction with the given locking [mode]. If a transaction is already open, this starts a nested
+     * savepoint and [mode] has no effect.
+     *
+     * The default only supports DEFERRED, which is what [beginTransaction] without a mode does.
+     */
+    fun beginTransaction(mode: TransactionMode) {
+        if (mode != TransactionMode.DEFERRED)
+            throw UnsupportedOperationException("${this::class.simpleName} doesn't support $mode transactions")
+        beginTransaction()
+    }
     fun setTransactionSuccessful()
     fun endTransaction()
     fun close()
     val closed:Boolean
 
+    /**
+     * Aborts whatever statement is running on this connection, which then fails with SQLiteInterruptedException. An
+     * interrupted write inside an explicit transaction rolls back the whole transaction. Safe to call from any thread,
+     * and doesn't wait for the connection's lock. Does nothing if no statement is running.
+     */
+    fun interrupt() {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support interrupt")
+    }
+
+    /**
+     * Runs [block] with a deadline [timeoutMillis] from now. Statements still running when it passes are aborted
+     * with SQLiteInterruptedException, with deadlineExceeded set, as are any started after it. A nested call can
+     * shorten the deadline but not extend it. Wrap a single statement for a per-statement deadline, or a
+     * withTransaction call for a per-transaction one.
+     *
+     * Only applies inside [block]. Cursors stepped after it returns have no deadline.
+     */
+    fun <R> withDeadline(timeoutMillis: Long, block: (DatabaseConnection) -> R): R {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support deadlines")
+    }
+
+    /**
+     * Opens a handle for incremental reads, and writes if [writable], of one blob value in the main database. See
+     * [Blob].
+     */
+    fun openBlob(table: String, column: String, rowId: Long, writable: Boolean = false): Blob {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support incremental blob I/O")
+    }
+
+    /**
+     * Makes [function] callable from SQL on this connection. See [SqlFunction]. To register on every connection,
+     * use DatabaseConfiguration.Extended.functions instead.
+     */
+    fun registerFunction(function: SqlFunction) {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support SQL functions")
+    }
+
+    /**
+     * Hit/miss counters for the prepared statement cache. See DatabaseConfiguration.Extended.statementCacheSize.
+     */
+    fun statementCacheStats(): StatementCacheStats = StatementCacheStats(0, 0, 0, 0, 0)
+
+    /**
+     * sqlite3_stmt_status totals per SQL string, for statements that have been finalized on this connection. Empty
+     * unless DatabaseConfiguration.Logging.statementMetrics is enabled.
+     */
+    fun statementStats(): Map<String, StatementStats> = emptyMap()
+
     // Added here: https://github.com/touchlab/SQLiter/pull/73
     // I refactored a lot of the API to be internal but some clients need access to the underlying pointer.
     // This call may get moved in the future, or changed in some way, but some calling clients do need access to the
@@ -34,6 +98,14 @@ interface DatabaseConnection {
     fun getDbPointer(): SqliteDatabasePointer
 }
 
+data class StatementCacheStats(
+    val hits: Long,
+    val misses: Long,
+    val evictions: Long,
+    val size: Int,
+    val maxSize: Int
+)
+
 fun <R> DatabaseConnection.withStatement(sql: String, proc: Statement.() -> R): R {
     val statement = createStatement(sql)
     try {
@@ -45,6 +117,15 @@ fun <R> DatabaseConnection.withStatement(sql: String, proc: Statement.() -> R):
 
 fun <R> DatabaseConnection.withTransaction(proc: (DatabaseConnection) -> R): R {
     beginTransaction()
+    return finishTransaction(proc)
+}
+
+fun <R> DatabaseConnection.withTransaction(mode: TransactionMode, proc: (DatabaseConnection) -> R): R {
+    beginTransaction(mode)
+    return finishTransaction(proc)
+}
+
+private inline fun <R> DatabaseConnection.finishTransaction(proc: (DatabaseConnection) -> R): R {
     try {
         val result = proc(this)
         setTransactionSuccessful()
@@ -54,6 +135,27 @@ fun <R> DatabaseConnection.withTransaction(proc: (DatabaseConnection) -> R): R {
     }
 }
 
+fun DatabaseConnection.registerFunction(
+    name: String,
+    argCount: Int,
+    deterministic: Boolean = false,
+    function: SqlResult.(SqlArguments) -> Unit
+) = registerFunction(SqlFunction.Scalar(name, argCount, deterministic, function = function))
+
+fun DatabaseConnection.registerAggregateFunction(
+    name: String,
+    argCount: Int,
+    deterministic: Boolean = false,
+    factory: () -> SqlAggregate
+) = registerFunction(SqlFunction.Aggregate(name, argCount, deterministic, factory = factory))
+
+fun DatabaseConnection.registerWindowFunction(
+    name: String,
+    argCount: Int,
+    deterministic: Boolean = false,
+    factory: () -> SqlWindowAggregate
+) = registerFunction(SqlFunction.Window(name, argCount, deterministic, factory = factory))
+
 fun DatabaseConnection.longForQuery(sql: String): Long = withStatement(sql) {
     longForQuery()
 }
@@ -121,6 +223,38 @@ fun DatabaseConnection.updateSynchronousFlag(flag: SynchronousFlag) {
     withStatement("PRAGMA synchronous=${flag.value}") { execute() }
 }
 
+/**
+ * Only takes effect before the database file is created, or after a VACUUM, and not at all in WAL mode once the
+ * file exists.
+ */
+fun DatabaseConnection.updatePageSize(pageSize: Int) {
+    withStatement("PRAGMA page_size=$pageSize") { execute() }
+}
+
+/**
+ * Returns the size actually applied, which sqlite caps at its compile time maximum. 0 means memory mapping is off.
+ */
+fun DatabaseConnection.updateMmapSize(bytes: Long): Long = longForQuery("PRAGMA mmap_size=$bytes")
+
+/**
+ * Positive values are a number of pages. Negative values are a size in KiB, so -8000 is about 8MB whatever the page
+ * size.
+ */
+fun DatabaseConnection.updateCacheSize(size: Int) {
+    withStatement("PRAGMA cache_size=$size") { execute() }
+}
+
+fun DatabaseConnection.updateTempStore(tempStore: TempStore) {
+    withStatement("PRAGMA temp_store=${tempStore.value}") { execute() }
+}
+
+/**
+ * Checkpoint the WAL once it reaches [pages] pages. 0 turns automatic checkpoints off.
+ */
+fun DatabaseConnection.updateWalAutoCheckpoint(pages: Int) {
+    longForQuery("PRAGMA wal_autocheckpoint=$pages")
+}
+
 fun DatabaseConnection.updateRecursiveTriggers(enabled: Boolean) {
     withStatement("PRAGMA recursive_triggers=${enabled.toInt()}") { execute() }
 }
@@ -16,6 +16,10 @@
 
 package co.touchlab.sqliter
 
+/**
+ * Members added after the first release have defaults, so existing implementations keep compiling. Statistics
+ * default to empty, and features that need the implementation's support throw UnsupportedOperationException.
+ */
 interface DatabaseManager{
     /**
      * Create a connection with locked access to the underlying sqlite instance. Use this
@@ -29,9 +33,104 @@ interface DatabaseManager{
      * if you are attempting otherwise. Performance is better, but marginally so.
      */
     fun createSingleThreadedConnection():DatabaseConnection
+
+    /**
+     * Create a pool with one writer connection and up to DatabaseConfiguration.Extended.readerConnectionCount
+     * read-only connections. Intended for JournalMode.WAL, where readers run concurrently with each other
+     * and the writer.
+     */
+    fun createConnectionPool():ConnectionPool {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support connection pools")
+    }
+
+    /**
+     * Create a queue that batches writes from many threads into shared transactions on its own connection and
+     * writer thread. See [WriteQueue].
+     */
+    fun createWriteQueue():WriteQueue {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support write queues")
+    }
+
+    /**
+     * Latency summaries per SQL fingerprint, across all connections from this manager. Empty unless
+     * DatabaseConfiguration.Logging.statementMetrics is enabled.
+     */
+    fun statementMetrics():List<StatementLatency> = emptyList()
+    fun resetStatementMetrics() {}
+
+    /**
+     * Totals for busy retries done according to DatabaseConfiguration.Extended.busyStrategy.
+     */
+    fun busyStats():BusyStats = BusyStats(0, 0, 0)
+
+    /**
+     * Totals for background checkpoints. All zero unless DatabaseConfiguration.Extended.backgroundCheckpoint is on.
+     */
+    fun checkpointStats():CheckpointStats = CheckpointStats(0, 0, 0, 0, 0, 0, 0, 0, 0)
+
+    /**
+     * Calls [listener] after each commit that changed rows, on any connection from this manager, with the set of
+     * changed tables. Rows changed in one transaction are reported together, once, and nothing is reported for
+     * transactions that roll back. See [TableChangeListener].
+     *
+     * Changes come from sqlite3_update_hook, which doesn't see changes made by other processes or other managers,
+     * WITHOUT ROWID tables, rows removed by ON CONFLICT REPLACE, or DELETEs without a WHERE clause that sqlite runs
+     * as a truncate.
+     */
+    fun addTableChangeListener(listener:TableChangeListener) {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support table change listeners")
+    }
+    fun removeTableChangeListener(listener:TableChangeListener) {}
+
+    /**
+     * Copies the database to [path] with sqlite's online backup API, [pagesPerStep] pages at a time (negative copies
+     * everything in one step). The source is only locked while a step runs, so other connections keep reading and
+     * writing in between. A write to the source from another connection makes the next step start over.
+     *
+     * Anything already at [path] is replaced. [progress] is called after each step with the remaining and total page
+     * counts. Busy steps are retried according to DatabaseConfiguration.Extended.busyStrategy.
+     *
+     * The backup sleeps [stepDelayMillis] (0 until 1000) between steps, so writers waiting on the source get the lock.
+     * 0 runs the steps back to back.
+     */
+    fun backupTo(
+        path:String,
+        pagesPerStep:Int = 100,
+        stepDelayMillis:Int = 10,
+        progress:(remaining:Int, total:Int) -> Unit = { _, _ -> }
+    ) {
+        throw UnsupportedOperationException("${this::class.simpleName} doesn't support online backup")
+    }
+
+    /**
+     * Writes a vacuumed copy of the database to [path] with VACUUM INTO. Unlike [backupTo] this runs as one read
+     * transaction and produces a compacted file, but [path] must not already exist.
+     */
+    fun vacuumInto(path:String) {
+        withConnection { conn ->
+            conn.withStatement("VACUUM INTO ?") {
+                bindString(1, path)
+                execute()
+            }
+        }
+    }
     val configuration:DatabaseConfiguration
 }
 
+/**
+ * Backs up to the file [destination] would open. See [DatabaseManager.backupTo].
+ */
+fun DatabaseManager.backupTo(
+    destination:DatabaseConfiguration,
+    pagesPerStep:Int = 100,
+    stepDelayMillis:Int = 10,
+    progress:(remaining:Int, total:Int) -> Unit = { _, _ -> }
+) {
+    val name = requireNotNull(destination.name) { "Backup destination must have a name" }
+    require(!destination.inMemory) { "Backup destination must be on disk" }
+    backupTo(DatabaseFileContext.databasePath(name, destination.extendedConfig.basePath), pagesPerStep, stepDelayMillis, progress)
+}
+
 fun <R> DatabaseManager.withConnection(block:(DatabaseConnection) -> R):R{
     val connection = createMultiThreadedConnection()
     try {
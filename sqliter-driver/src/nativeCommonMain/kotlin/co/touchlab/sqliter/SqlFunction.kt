@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * A Kotlin function callable from SQL. Register it on one connection with DatabaseConnection.registerFunction, or on
+ * every connection a manager opens with DatabaseConfiguration.Extended.functions.
+ *
+ * [deterministic] functions always return the same result for the same arguments, which lets sqlite use them in
+ * indexes and partial index conditions and factor them out of loops. [innocuous] functions have no side effects and
+ * can be used in views, triggers and schema definitions even when trusted_schema is off.
+ *
+ * [argCount] of -1 accepts any number of arguments.
+ */
+sealed class SqlFunction(
+    val name: String,
+    val argCount: Int,
+    val deterministic: Boolean,
+    val innocuous: Boolean
+) {
+    init {
+        require(argCount in -1..127) { "argCount must be -1 to 127" }
+    }
+
+    /**
+     * Called once per row, with the arguments, to set the result.
+     */
+    class Scalar(
+        name: String,
+        argCount: Int,
+        deterministic: Boolean = false,
+        innocuous: Boolean = false,
+        val function: SqlResult.(SqlArguments) -> Unit
+    ) : SqlFunction(name, argCount, deterministic, innocuous)
+
+    /**
+     * [factory] creates an accumulator for each group.
+     */
+    class Aggregate(
+        name: String,
+        argCount: Int,
+        deterministic: Boolean = false,
+        innocuous: Boolean = false,
+        val factory: () -> SqlAggregate
+    ) : SqlFunction(name, argCount, deterministic, innocuous)
+
+    /**
+     * Usable both as a plain aggregate and with an OVER clause. [factory] creates an accumulator for each group or
+     * window partition.
+     */
+    class Window(
+        name: String,
+        argCount: Int,
+        deterministic: Boolean = false,
+        innocuous: Boolean = false,
+        val factory: () -> SqlWindowAggregate
+    ) : SqlFunction(name, argCount, deterministic, innocuous)
+}
+
+/**
+ * Accumulator for one group of an aggregate function.
+ */
+interface SqlAggregate {
+    /**
+     * Adds one row.
+     */
+    fun step(args: SqlArguments)
+
+    /**
+     * Sets the aggregate's value. Called once at the end of the group, or, for window functions, each time the
+     * window's current value is needed.
+     */
+    fun result(result: SqlResult)
+}
+
+interface SqlWindowAggregate : SqlAggregate {
+    /**
+     * Removes one row, previously passed to [step], that has left the window.
+     */
+    fun inverse(args: SqlArguments)
+}
+
+/**
+ * Arguments to the current call, read straight from sqlite's values. Only valid during the call.
+ */
+interface SqlArguments {
+    val size: Int
+    fun isNull(index: Int): Boolean
+    fun getType(index: Int): FieldType
+    fun getLong(index: Int): Long
+    fun getDouble(index: Int): Double
+    fun getString(index: Int): String
+    fun getBytes(index: Int): ByteArray
+}
+
+/**
+ * Sets the value returned to sqlite. Only valid during the call. If nothing is set, the result is NULL. If the
+ * function throws, the statement fails with the exception's message.
+ */
+interface SqlResult {
+    fun setNull()
+    fun setLong(value: Long)
+    fun setDouble(value: Double)
+    fun setString(value: String)
+    fun setBytes(value: ByteArray)
+    fun setError(message: String)
+}
+
+fun SqlArguments.getStringOrNull(index: Int): String? = if (isNull(index)) null else getString(index)
+
+fun SqlArguments.getLongOrNull(index: Int): Long? = if (isNull(index)) null else getLong(index)
+
+fun SqlArguments.getDoubleOrNull(index: Int): Double? = if (isNull(index)) null else getDouble(index)
+
+fun SqlArguments.getBytesOrNull(index: Int): ByteArray? = if (isNull(index)) null else getBytes(index)
@@ -16,6 +16,10 @@
 
 package co.touchlab.sqliter
 
+/**
+ * Members added after the first release have defaults, built on the older members, so existing implementations keep
+ * compiling.
+ */
 interface Statement{
     fun execute()
     fun executeInsert():Long
@@ -29,7 +33,80 @@ interface Statement{
     fun bindDouble(index:Int, value:Double)
     fun bindString(index:Int, value:String)
     fun bindBlob(index:Int, value:ByteArray)
+
+    /**
+     * Binds a blob of [size] zero bytes without allocating it, to be filled in later with DatabaseConnection.openBlob.
+     * The default binds an allocated array of zeros.
+     */
+    fun bindZeroBlob(index:Int, size:Int) {
+        bindBlob(index, ByteArray(size))
+    }
     fun bindParameterIndex(paramName:String):Int
+
+    /**
+     * Binds and executes one row at a time from [rows], resetting and clearing bindings between rows, so a
+     * parameter [bind] skips for a row is null rather than the previous row's value. The whole batch runs under a
+     * single lock acquisition, and inside one transaction if the connection doesn't already have one open.
+     *
+     * [bind] is called with the underlying statement, so bind calls in it don't go through the connection lock.
+     *
+     * Returns the last inserted rowid or the changed row count for each row, depending on [returning].
+     *
+     * The default executes row by row through this interface, without a lock or transaction of its own.
+     */
+    fun <T> executeBatch(rows: Iterator<T>, returning: BatchResult, bind: Statement.(T) -> Unit): LongArray {
+        val results = ArrayList<Long>()
+        try {
+            while (rows.hasNext()) {
+                bind(rows.next())
+                results.add(
+                    when (returning) {
+                        BatchResult.ROW_ID -> executeInsert()
+                        BatchResult.CHANGED_ROWS -> executeUpdateDelete().toLong()
+                    }
+                )
+                resetStatement()
+                clearBindings()
+            }
+        } finally {
+            resetStatement()
+            clearBindings()
+        }
+        return results.toLongArray()
+    }
+
+    /**
+     * sqlite3_stmt_status counters for this statement. If [reset] is true, counters are zeroed after reading.
+     */
+    fun stats(reset: Boolean = false): StatementStats = StatementStats(0, 0, 0, 0, 0, 0, 0)
+}
+
+/**
+ * Counters from sqlite3_stmt_status. Non-zero [fullScanSteps], [sorts] or [autoIndexes] usually mean a query is
+ * missing an index. [memoryUsed] is the current size of the statement in bytes, not a counter.
+ */
+data class StatementStats(
+    val fullScanSteps: Long,
+    val sorts: Long,
+    val autoIndexes: Long,
+    val vmSteps: Long,
+    val reprepares: Long,
+    val runs: Long,
+    val memoryUsed: Long
+) {
+    operator fun plus(other: StatementStats): StatementStats = StatementStats(
+        fullScanSteps = fullScanSteps + other.fullScanSteps,
+        sorts = sorts + other.sorts,
+        autoIndexes = autoIndexes + other.autoIndexes,
+        vmSteps = vmSteps + other.vmSteps,
+        reprepares = reprepares + other.reprepares,
+        runs = runs + other.runs,
+        memoryUsed = maxOf(memoryUsed, other.memoryUsed)
+    )
+}
+
+enum class BatchResult {
+    ROW_ID, CHANGED_ROWS
 }
 
 fun Statement.bindLong(index:Int, value:Long?){
@@ -60,6 +137,28 @@ fun Statement.bindBlob(index:Int, value:ByteArray?){
         bindBlob(index, value)
 }
 
+fun <T> Statement.executeBatch(
+    rows: Iterable<T>,
+    returning: BatchResult = BatchResult.ROW_ID,
+    bind: Statement.(T) -> Unit
+): LongArray = executeBatch(rows.iterator(), returning, bind)
+
+fun <T> Statement.executeBatch(
+    rows: Sequence<T>,
+    returning: BatchResult = BatchResult.ROW_ID,
+    bind: Statement.(T) -> Unit
+): LongArray = executeBatch(rows.iterator(), returning, bind)
+
+/**
+ * Columnar variant. [bind] is called with each row index in 0 until [rowCount], so values can be pulled straight
+ * from parallel arrays.
+ */
+fun Statement.executeBatch(
+    rowCount: Int,
+    returning: BatchResult = BatchResult.ROW_ID,
+    bind: Statement.(Int) -> Unit
+): LongArray = executeBatch((0 until rowCount).iterator(), returning, bind)
+
 fun Statement.longForQuery():Long{
     try {
         val query = query()
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * Latency summary for one SQL fingerprint, from DatabaseManager.statementMetrics(). Percentiles come from a
+ * log-linear histogram and are accurate to within 25%. [maxNanos] is exact.
+ *
+ * Timings cover execute/executeInsert/executeUpdateDelete calls, and cursors from query() until the statement is
+ * reset or finalized.
+ */
+data class StatementLatency(
+    val sql: String,
+    val count: Long,
+    val totalNanos: Long,
+    val p50Nanos: Long,
+    val p95Nanos: Long,
+    val p99Nanos: Long,
+    val maxNanos: Long
+)
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * Receives the tables changed by each committed transaction. Register with DatabaseManager.addTableChangeListener.
+ *
+ * Called on the committing thread after the commit, with that connection still locked. Implementations should be
+ * quick, and hand real work, like re-running dependent queries, to another thread.
+ */
+interface TableChangeListener {
+    /**
+     * [tables] were changed by a transaction that has just committed. Tables in attached databases are named
+     * "schema.table". Changes to temp tables aren't reported.
+     */
+    fun onTablesChanged(tables: Set<String>)
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+/**
+ * Funnels writes from many threads through one connection on a dedicated writer thread. Whatever is queued when
+ * the writer becomes free is run in a single transaction, so the cost of a commit (an fsync, with WAL) is shared
+ * by the whole batch instead of paid once per caller.
+ *
+ * Each write runs inside its own savepoint. If it throws, only its own changes are rolled back and the exception is
+ * reported to that caller. The rest of the batch still commits. If the commit itself fails, every write in the batch
+ * fails with that error.
+ *
+ * Batch limits are set with DatabaseConfiguration.Extended.writeQueueMaxBatch and writeQueueMaxDelayMillis.
+ *
+ * The connection passed to a write belongs to the writer thread. Don't keep it, or statements and cursors created
+ * from it, after the write returns. Transactions started in a write nest inside the batch's transaction.
+ */
+interface WriteQueue {
+    /**
+     * Queues [block] and waits until the batch containing it has committed. Returns the block's result, or throws
+     * what it threw.
+     */
+    fun <R> write(block: (DatabaseConnection) -> R): R = submit(block).await()
+
+    /**
+     * Queues [block] without waiting for it.
+     */
+    fun <R> submit(block: (DatabaseConnection) -> R): PendingWrite<R>
+
+    /**
+     * Runs everything already queued, then stops the writer thread and closes its connection. Calls after close fail.
+     */
+    fun close()
+}
+
+interface PendingWrite<R> {
+    /**
+     * True once the write's batch has committed or failed.
+     */
+    val isDone: Boolean
+
+    /**
+     * Waits for the write's batch to commit, then returns the result or throws what the write threw.
+     */
+    fun await(): R
+}
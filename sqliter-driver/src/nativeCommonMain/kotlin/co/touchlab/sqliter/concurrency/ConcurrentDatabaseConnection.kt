@@ -16,11 +16,20 @@
 
 package co.touchlab.sqliter.concurrency
 
+import co.touchlab.sqliter.BatchResult
+import co.touchlab.sqliter.Blob
+import co.touchlab.sqliter.ColumnChunk
 import co.touchlab.sqliter.Cursor
 import co.touchlab.sqliter.DatabaseConnection
 import co.touchlab.sqliter.FieldType
+import co.touchlab.sqliter.SqlFunction
 import co.touchlab.sqliter.Statement
+import co.touchlab.sqliter.StatementCacheStats
+import co.touchlab.sqliter.StatementStats
+import co.touchlab.sqliter.TransactionMode
 import co.touchlab.sqliter.interop.SqliteDatabasePointer
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
 
 internal class ConcurrentDatabaseConnection(private val delegateConnection: DatabaseConnection) : DatabaseConnection {
     private val accessLock = Lock()
@@ -32,6 +41,8 @@ internal class ConcurrentDatabaseConnection(private val delegateConnection: Data
 
     override fun beginTransaction() = accessLock.withLock { delegateConnection.beginTransaction() }
 
+    override fun beginTransaction(mode: TransactionMode) = accessLock.withLock { delegateConnection.beginTransaction(mode) }
+
     override fun setTransactionSuccessful() = accessLock.withLock { delegateConnection.setTransactionSuccessful() }
 
     override fun endTransaction() = accessLock.withLock { delegateConnection.endTransaction() }
@@ -41,6 +52,22 @@ internal class ConcurrentDatabaseConnection(private val delegateConnection: Data
     override val closed: Boolean
         get() = delegateConnection.closed
 
+    //Not locked, so it can reach a statement running on another thread
+    override fun interrupt() = delegateConnection.interrupt()
+
+    //The lock is held for the whole block, so other threads' statements aren't subject to this deadline
+    override fun <R> withDeadline(timeoutMillis: Long, block: (DatabaseConnection) -> R): R =
+        accessLock.withLock { delegateConnection.withDeadline(timeoutMillis) { block(this) } }
+
+    override fun openBlob(table: String, column: String, rowId: Long, writable: Boolean): Blob =
+        accessLock.withLock { ConcurrentBlob(delegateConnection.openBlob(table, column, rowId, writable)) }
+
+    override fun registerFunction(function: SqlFunction) = accessLock.withLock { delegateConnection.registerFunction(function) }
+
+    override fun statementCacheStats(): StatementCacheStats = accessLock.withLock { delegateConnection.statementCacheStats() }
+
+    override fun statementStats(): Map<String, StatementStats> = accessLock.withLock { delegateConnection.statementStats() }
+
     override fun getDbPointer(): SqliteDatabasePointer = delegateConnection.getDbPointer()
 
     inner class ConcurrentCursor(private val delegateCursor: Cursor) : Cursor {
@@ -56,8 +83,19 @@ internal class ConcurrentDatabaseConnection(private val delegateConnection: Data
 
         override fun getDouble(index: Int): Double = accessLock.withLock { delegateCursor.getDouble(index) }
 
+        override fun <R> withBlob(index: Int, block: (bytes: CPointer<ByteVar>?, size: Int) -> R): R =
+            accessLock.withLock { delegateCursor.withBlob(index, block) }
+
+        override fun <R> withText(index: Int, block: (utf8: CPointer<ByteVar>?, size: Int) -> R): R =
+            accessLock.withLock { delegateCursor.withText(index, block) }
+
+        override fun getBytesInto(index: Int, dest: ByteArray, offset: Int): Int =
+            accessLock.withLock { delegateCursor.getBytesInto(index, dest, offset) }
+
         override fun getType(index: Int): FieldType = accessLock.withLock { delegateCursor.getType(index) }
 
+        override fun getTypes(types: IntArray): Int = accessLock.withLock { delegateCursor.getTypes(types) }
+
         override val columnCount: Int
             get() = accessLock.withLock { delegateCursor.columnCount }
 
@@ -68,6 +106,26 @@ internal class ConcurrentDatabaseConnection(private val delegateConnection: Data
         override val statement: Statement
             get() = accessLock.withLock { delegateCursor.statement }
 
+        override fun fetchColumns(chunk: ColumnChunk): Int = accessLock.withLock { delegateCursor.fetchColumns(chunk) }
+
+    }
+
+    inner class ConcurrentBlob(private val delegateBlob: Blob) : Blob {
+        override val size: Int
+            get() = accessLock.withLock { delegateBlob.size }
+
+        override val writable: Boolean
+            get() = delegateBlob.writable
+
+        override fun read(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) =
+            accessLock.withLock { delegateBlob.read(offset, buffer, bufferOffset, length) }
+
+        override fun write(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) =
+            accessLock.withLock { delegateBlob.write(offset, buffer, bufferOffset, length) }
+
+        override fun reopen(rowId: Long) = accessLock.withLock { delegateBlob.reopen(rowId) }
+
+        override fun close() = accessLock.withLock { delegateBlob.close() }
     }
 
     inner class ConcurrentStatement(internal val delegateStatement: Statement) : Statement {
@@ -99,7 +157,15 @@ internal class ConcurrentDatabaseConnection(private val delegateConnection: Data
         override fun bindBlob(index: Int, value: ByteArray) =
             accessLock.withLock { delegateStatement.bindBlob(index, value) }
 
+        override fun bindZeroBlob(index: Int, size: Int) =
+            accessLock.withLock { delegateStatement.bindZeroBlob(index, size) }
+
         override fun bindParameterIndex(paramName: String): Int =
             accessLock.withLock { delegateStatement.bindParameterIndex(paramName) }
+
+        override fun stats(reset: Boolean): StatementStats = accessLock.withLock { delegateStatement.stats(reset) }
+
+        override fun <T> executeBatch(rows: Iterator<T>, returning: BatchResult, bind: Statement.(T) -> Unit): LongArray =
+            accessLock.withLock { delegateStatement.executeBatch(rows, returning, bind) }
     }
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+package co.touchlab.sqliter.concurrency
+
+/**
+ * A mutex with a condition variable, for threads that need to wait on shared state.
+ * Unlike Lock, implementations of this class are not re-entrant.
+ */
+internal expect class Condition() {
+    fun lock()
+    fun unlock()
+
+    /**
+     * Releases the lock and waits for a signal. The lock is held again when this returns. Spurious wakeups
+     * are possible, so callers should re-check their state in a loop.
+     */
+    fun await()
+
+    /**
+     * Like [await], but also returns after about [timeoutNanos] without a signal.
+     */
+    fun await(timeoutNanos: Long)
+    fun signalAll()
+}
+
+/**
+ * Frees the native mutex and condition right away instead of when the Condition is collected. Only call it once no
+ * thread can lock or wait on it again.
+ */
+internal expect inline fun Condition.close()
+
+internal inline fun <T> Condition.withLock(block: () -> T): T {
+    lock()
+    try {
+        return block()
+    } finally {
+        unlock()
+    }
+}
@@ -1,8 +1,10 @@
 package co.touchlab.sqliter.interop
 
+import co.touchlab.sqliter.StatementStats
 import kotlinx.cinterop.*
 import co.touchlab.sqliter.sqlite3.*
 import platform.posix.usleep
+import kotlin.system.getTimeNanos
 
 expect inline fun bytesToString(bv:CPointer<ByteVar>):String
 
@@ -40,6 +42,15 @@ internal class ActualSqliteStatement(private val db: SqliteDatabase, private val
         return blob.readBytes(blobSize)
     }
 
+    override fun columnBlobPointer(columnIndex: Int): CPointer<ByteVar>? =
+        sqlite3_column_blob(stmtPointer, columnIndex)?.reinterpret()
+
+    override fun columnTextPointer(columnIndex: Int): CPointer<ByteVar>? =
+        sqlite3_column_text(stmtPointer, columnIndex)?.reinterpret()
+
+    override fun columnBytes(columnIndex: Int): Int =
+        sqlite3_column_bytes(stmtPointer, columnIndex)
+
     override fun columnCount(): Int =
         sqlite3_column_count(stmtPointer)
 
@@ -50,24 +61,39 @@ internal class ActualSqliteStatement(private val db: SqliteDatabase, private val
         sqlite3_column_type(stmtPointer, columnIndex)
 
     override fun step(): Boolean {
-
-        //Maybe move a first call to pre-loop
-        for (retryCount in 0 until 50) {
+        var attempt = 0
+        var waitedNanos = 0L
+        val interrupts = db.interruptCount.value
+        while (true) {
             val err = sqlite3_step(stmtPointer)
             if (err == SQLITE_ROW) {
-                return true;
+                return true
             } else if (err == SQLITE_DONE) {
-                return false;
+                return false
             } else if (err == SQLITE_LOCKED || err == SQLITE_BUSY) {
+                val delay = db.busyStrategy.nextDelayMicros(attempt++, waitedNanos)
+                if (delay < 0) {
+                    db.busyCounters?.failed()
+                    throw sqlException(db.logger, db.config, "sqlite3_step busy after $attempt attempts", err)
+                }
+                if (db.interruptCount.value != interrupts) {
+                    throw sqlException(db.logger, db.config, "sqlite3_step interrupted while busy", SQLITE_INTERRUPT)
+                }
+                if (db.deadlineNanos != 0L && getTimeNanos() + delay * 1000 >= db.deadlineNanos) {
+                    throw sqlException(db.logger, db.config, "sqlite3_step busy past deadline", SQLITE_INTERRUPT, true)
+                }
+
                 // The table is locked, retry
                 traceLogCallback("Database locked, retrying")
-                usleep(1000u)
+                val start = getTimeNanos()
+                usleep(delay.toUInt())
+                val waited = getTimeNanos() - start
+                waitedNanos += waited
+                db.busyCounters?.retried(waited)
             } else {
-                throw sqlException(db.logger, db.config, "sqlite3_step failed", err)
+                throw sqlException(db.logger, db.config, "sqlite3_step failed", err, db.deadlineExpired)
             }
         }
-
-        throw sqlException(db.logger, db.config, "sqlite3_step retry count exceeded")
     }
 
     //Statement methods
@@ -137,6 +163,10 @@ internal class ActualSqliteStatement(private val db: SqliteDatabase, private val
         }
     }
 
+    override fun bindZeroBlob(index: Int, size: Int) = opResult(db) {
+        sqlite3_bind_zeroblob(stmtPointer, index, size)
+    }
+
     private inline fun opResult(db: SqliteDatabase, block: () -> Int) {
         val err = block()
         if (err != SQLITE_OK) {
@@ -150,11 +180,27 @@ internal class ActualSqliteStatement(private val db: SqliteDatabase, private val
         if (err == SQLITE_ROW) {
             throw sqlException(db.logger, db.config, "Queries can be performed using SQLiteDatabase query or rawQuery methods only.")
         } else if (err != SQLITE_DONE) {
-            throw sqlException(db.logger, db.config, "executeNonQuery error", err)
+            throw sqlException(db.logger, db.config, "executeNonQuery error", err, db.deadlineExpired)
         }
         return err
     }
 
+    override fun stats(reset: Boolean): StatementStats {
+        val resetFlag = if (reset) 1 else 0
+        return StatementStats(
+            fullScanSteps = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_FULLSCAN_STEP, resetFlag).toLong(),
+            sorts = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_SORT, resetFlag).toLong(),
+            autoIndexes = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_AUTOINDEX, resetFlag).toLong(),
+            vmSteps = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_VM_STEP, resetFlag).toLong(),
+            reprepares = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_REPREPARE, resetFlag).toLong(),
+            runs = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_RUN, resetFlag).toLong(),
+            memoryUsed = sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_MEMUSED, 0).toLong()
+        )
+    }
+
+    override fun reprepareCount(): Int =
+        sqlite3_stmt_status(stmtPointer, SQLITE_STMTSTATUS_REPREPARE, 0)
+
     override fun traceLogCallback(message: String) {
         //No logging
     }
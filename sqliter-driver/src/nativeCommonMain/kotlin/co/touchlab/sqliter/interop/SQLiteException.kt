@@ -2,7 +2,7 @@ package co.touchlab.sqliter.interop
 
 open class SQLiteException internal constructor(message: String, private val config: SqliteDatabaseConfig) : Exception(message)
 
-class SQLiteExceptionErrorCode internal constructor(message: String, config: SqliteDatabaseConfig, private val errorCode: Int) : SQLiteException(message, config) {
+open class SQLiteExceptionErrorCode internal constructor(message: String, config: SqliteDatabaseConfig, private val errorCode: Int) : SQLiteException(message, config) {
     val errorType: SqliteErrorType by lazy {
         val checkErrorCode = errorCode and 0xff
         SqliteErrorType.values().find { it.code == checkErrorCode }
@@ -10,11 +10,32 @@ class SQLiteExceptionErrorCode internal constructor(message: String, config: Sql
     }
 }
 
-internal inline fun sqlException(logging: Logger, config: SqliteDatabaseConfig, message: String, errorCode: Int = -1): SQLiteException {
+/**
+ * A statement was aborted with SQLITE_INTERRUPT, either by DatabaseConnection.interrupt or because the deadline set by
+ * DatabaseConnection.withDeadline passed, in which case [deadlineExceeded] is true.
+ */
+class SQLiteInterruptedException internal constructor(
+    message: String,
+    config: SqliteDatabaseConfig,
+    errorCode: Int,
+    val deadlineExceeded: Boolean
+) : SQLiteExceptionErrorCode(message, config, errorCode)
+
+internal inline fun sqlException(
+    logging: Logger,
+    config: SqliteDatabaseConfig,
+    message: String,
+    errorCode: Int = -1,
+    deadlineExceeded: Boolean = false
+): SQLiteException {
     return if (errorCode == -1) {
         val sqLiteException = SQLiteException(message, config)
         logging.e(sqLiteException) { message }
         sqLiteException
+    } else if (errorCode and 0xff == co.touchlab.sqliter.sqlite3.SQLITE_INTERRUPT) {
+        val sqLiteException = SQLiteInterruptedException(message, config, errorCode, deadlineExceeded)
+        logging.e(sqLiteException) { if (deadlineExceeded) "$message | deadline exceeded" else "$message | interrupted" }
+        sqLiteException
     } else {
         val sqLiteException = SQLiteExceptionErrorCode(message, config, errorCode)
         logging.e(sqLiteException) { "$message | error code ${sqLiteException.errorType}" }
@@ -0,0 +1,29 @@
+package co.touchlab.sqliter.interop
+
+/**
+ * Receives sqlite3_trace_v2 events. Enable with DatabaseConfiguration.Logging.enableTrace and enableProfile.
+ *
+ * Called on the thread running the statement, while it's running, so implementations should be quick and must
+ * not call back into the connection.
+ */
+interface SqlTraceListener {
+    /**
+     * SQLITE_TRACE_STMT. A statement started running. [sql] is the unexpanded SQL, or a "--" comment for triggers.
+     */
+    fun onStatement(sql: String)
+
+    /**
+     * SQLITE_TRACE_PROFILE. A statement finished, taking approximately [elapsedNanos].
+     */
+    fun onProfile(sql: String, elapsedNanos: Long)
+}
+
+internal class LoggerTraceListener(private val logger: Logger) : SqlTraceListener {
+    override fun onStatement(sql: String) {
+        logger.trace("trace: $sql")
+    }
+
+    override fun onProfile(sql: String, elapsedNanos: Long) {
+        logger.trace("profile: $sql took ${elapsedNanos / 1000}us")
+    }
+}
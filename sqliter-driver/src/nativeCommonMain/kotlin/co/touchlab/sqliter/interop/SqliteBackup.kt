@@ -0,0 +1,77 @@
+package co.touchlab.sqliter.interop
+
+import cnames.structs.sqlite3
+import kotlinx.cinterop.*
+import co.touchlab.sqliter.sqlite3.*
+import platform.posix.usleep
+import kotlin.system.getTimeNanos
+
+/**
+ * Copies this database to [destPath] with the sqlite3_backup API, [pagesPerStep] pages at a time. The source is only
+ * locked during each step, so other connections can read and write between steps. If another connection writes to
+ * the source, sqlite restarts the copy from the beginning on the next step.
+ *
+ * Anything already at [destPath] is replaced. [progress] is called after each step with the remaining and total
+ * page counts.
+ */
+internal fun SqliteDatabase.backupTo(
+    destPath: String,
+    pagesPerStep: Int,
+    stepDelayMillis: Int,
+    progress: (remaining: Int, total: Int) -> Unit
+) {
+    val dest = memScoped {
+        val destPtr = alloc<CPointerVar<sqlite3>>()
+        val err = sqlite3_open_v2(destPath, destPtr.ptr, SQLITE_OPEN_READWRITE or SQLITE_OPEN_CREATE or SQLITE_OPEN_URI, null)
+        if (err != SQLITE_OK) {
+            val error = sqlite3_errmsg(destPtr.value)?.toKString()
+            sqlite3_close_v2(destPtr.value)
+            throw sqlException(logger, config, "Cannot open backup destination $destPath ${error ?: ""}", err)
+        }
+        destPtr.value!!
+    }
+
+    try {
+        val backup = sqlite3_backup_init(dest, "main", dbPointer, "main")
+            ?: throw sqlException(logger, config, "sqlite3_backup_init failed ${sqlite3_errmsg(dest)?.toKString() ?: ""}", sqlite3_errcode(dest))
+
+        try {
+            var attempt = 0
+            var waitedNanos = 0L
+            while (true) {
+                val err = sqlite3_backup_step(backup, pagesPerStep)
+                if (err == SQLITE_OK || err == SQLITE_DONE) {
+                    attempt = 0
+                    waitedNanos = 0L
+                    progress(sqlite3_backup_remaining(backup), sqlite3_backup_pagecount(backup))
+                    if (err == SQLITE_DONE)
+                        break
+                    // Give writers a chance at the source between steps. Yielding alone isn't enough: the source is
+                    // free for a moment, but a writer waiting in its busy handler rarely wakes up in time.
+                    if (stepDelayMillis > 0)
+                        usleep((stepDelayMillis * 1000).toUInt())
+                } else if (err == SQLITE_BUSY || err == SQLITE_LOCKED) {
+                    val delay = busyStrategy.nextDelayMicros(attempt++, waitedNanos)
+                    if (delay < 0) {
+                        throw sqlException(logger, config, "Backup busy after $attempt attempts", err)
+                    }
+                    val start = getTimeNanos()
+                    usleep(delay.toUInt())
+                    waitedNanos += getTimeNanos() - start
+                } else {
+                    throw sqlException(logger, config, "sqlite3_backup_step failed ${sqlite3_errmsg(dest)?.toKString() ?: ""}", err)
+                }
+            }
+        } catch (e: Exception) {
+            sqlite3_backup_finish(backup)
+            throw e
+        }
+
+        val err = sqlite3_backup_finish(backup)
+        if (err != SQLITE_OK) {
+            throw sqlException(logger, config, "sqlite3_backup_finish failed", err)
+        }
+    } finally {
+        sqlite3_close_v2(dest)
+    }
+}
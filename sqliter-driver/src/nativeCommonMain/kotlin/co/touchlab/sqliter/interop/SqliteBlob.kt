@@ -0,0 +1,36 @@
+package co.touchlab.sqliter.interop
+
+import cnames.structs.sqlite3_blob
+import kotlinx.cinterop.*
+import co.touchlab.sqliter.sqlite3.*
+
+internal class SqliteBlob(private val db: SqliteDatabase, private val blobPointer: CPointer<sqlite3_blob>) {
+    val size: Int
+        get() = sqlite3_blob_bytes(blobPointer)
+
+    fun read(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) = opResult("read") {
+        sqlite3_blob_read(blobPointer, buffer.refTo(bufferOffset), length, offset)
+    }
+
+    fun write(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) = opResult("write") {
+        sqlite3_blob_write(blobPointer, buffer.refTo(bufferOffset), length, offset)
+    }
+
+    fun reopen(rowId: Long) = opResult("reopen") {
+        sqlite3_blob_reopen(blobPointer, rowId)
+    }
+
+    fun close() {
+        // Like sqlite3_finalize, the handle is always closed regardless of the result.
+        db.logger.v { "Closed blob $blobPointer on connection $db" }
+        sqlite3_blob_close(blobPointer)
+    }
+
+    private inline fun opResult(op: String, block: () -> Int) {
+        val err = block()
+        if (err != SQLITE_OK) {
+            val error = sqlite3_errmsg(db.dbPointer)?.toKString()
+            throw sqlException(db.logger, db.config, "Blob $op failure ${error ?: ""}", err)
+        }
+    }
+}
@@ -1,21 +1,52 @@
 package co.touchlab.sqliter.interop
 
 import cnames.structs.sqlite3
+import cnames.structs.sqlite3_blob
 import cnames.structs.sqlite3_stmt
+import co.touchlab.sqliter.BusyCounters
+import co.touchlab.sqliter.BusyStrategy
 import kotlinx.cinterop.*
 import co.touchlab.sqliter.sqlite3.*
+import kotlin.concurrent.AtomicInt
+import kotlin.system.getTimeNanos
 
-internal class SqliteDatabase(path: String, label: String, val logger: Logger, private val verboseDataCalls: Boolean, val dbPointer: SqliteDatabasePointer) {
+internal class SqliteDatabase(
+    path: String,
+    label: String,
+    val logger: Logger,
+    private val verboseDataCalls: Boolean,
+    val dbPointer: SqliteDatabasePointer,
+    private val traceRef: StableRef<CallbackContext<SqlTraceListener>>? = null,
+    val busyStrategy: BusyStrategy = BusyStrategy.FixedDelay(),
+    val busyCounters: BusyCounters? = null
+) {
     val config = SqliteDatabaseConfig(path, label)
 
-    fun prepareStatement(sqlString: String): SqliteStatement {
+    /**
+     * Compiles UTF-8 SQL with sqlite3_prepare_v3, which avoids transcoding to UTF-16 and back. The length passed
+     * includes the NUL terminator, so sqlite can compile straight from our buffer instead of copying the SQL to
+     * terminate it.
+     *
+     * @param persistent hint to sqlite that the statement will be retained and reused many times. Used for
+     * cached statements.
+     */
+    fun prepareStatement(sqlString: String, persistent: Boolean = false): SqliteStatement {
+        if (sqlString.isEmpty()) {
+            throw sqlException(logger, config, "error while compiling: empty statement")
+        }
+
+        val prepFlags = if (persistent) SQLITE_PREPARE_PERSISTENT.toUInt() else 0u
+
         val statement = memScoped {
             val statementPtr = alloc<CPointerVar<sqlite3_stmt>>()
-            val sqlUgt16 = sqlString.wcstr
-            val err = sqlite3_prepare16_v2(
+            val sqlUtf8 = sqlString.cstr
+            val err = sqlite3_prepare_v3(
                 dbPointer,
-                sqlUgt16.ptr,
-                sqlUgt16.size, statementPtr.ptr, null
+                sqlUtf8.ptr,
+                sqlUtf8.size,
+                prepFlags,
+                statementPtr.ptr,
+                null
             )
 
             if (err != SQLITE_OK) {
@@ -24,7 +55,7 @@ internal class SqliteDatabase(path: String, label: String, val logger: Logger, p
                 throw sqlException(logger, config, "error while compiling: $sqlString\n$error", err)
             }
 
-            statementPtr.value!!
+            statementPtr.value ?: throw sqlException(logger, config, "error while compiling: $sqlString\nno statement")
         }
 
         logger.v { "prepareStatement for [$statement] on $config" }
@@ -37,17 +68,150 @@ internal class SqliteDatabase(path: String, label: String, val logger: Logger, p
         }
     }
 
+    fun openBlob(table: String, column: String, rowId: Long, writable: Boolean): SqliteBlob {
+        val blob = memScoped {
+            val blobPtr = alloc<CPointerVar<sqlite3_blob>>()
+            val err = sqlite3_blob_open(dbPointer, "main", table, column, rowId, if (writable) 1 else 0, blobPtr.ptr)
+            if (err != SQLITE_OK) {
+                val error = sqlite3_errmsg(dbPointer)?.toKString()
+                throw sqlException(logger, config, "error opening blob: $table.$column row $rowId\n$error", err)
+            }
+            blobPtr.value!!
+        }
+
+        logger.v { "openBlob for [$blob] on $config" }
+
+        return SqliteBlob(this, blob)
+    }
+
+    val inTransaction: Boolean
+        get() = sqlite3_get_autocommit(dbPointer) == 0
+
+    private var walHookRef: StableRef<CallbackContext<WalHookListener>>? = null
+
+    /**
+     * Registers [listener] with sqlite3_wal_hook. This replaces sqlite's automatic checkpoints on this connection,
+     * which use the same hook.
+     */
+    fun setWalHook(listener: WalHookListener) {
+        val ref = StableRef.create(CallbackContext(listener, logger))
+        sqlite3_wal_hook(dbPointer, walHookCallback, ref.asCPointer())
+        walHookRef?.dispose()
+        walHookRef = ref
+    }
+
+    fun checkpoint(mode: CheckpointMode): WalCheckpoint = memScoped {
+        val logFrames = alloc<IntVar>()
+        val checkpointedFrames = alloc<IntVar>()
+        val err = sqlite3_wal_checkpoint_v2(dbPointer, null, mode.sqliteMode, logFrames.ptr, checkpointedFrames.ptr)
+        // BUSY means RESTART or TRUNCATE got as far as it could, but readers or a writer kept it from finishing
+        if (err != SQLITE_OK && err != SQLITE_BUSY) {
+            val error = sqlite3_errmsg(dbPointer)?.toKString()
+            throw sqlException(logger, config, "wal checkpoint ${mode.name} failed ${error ?: ""}", err)
+        }
+        WalCheckpoint(err == SQLITE_BUSY, logFrames.value, checkpointedFrames.value)
+    }
+
+    private var changeHookRef: StableRef<CallbackContext<ChangeHookListener>>? = null
+
+    /**
+     * Registers [listener] with sqlite3_update_hook, sqlite3_commit_hook and sqlite3_rollback_hook.
+     */
+    fun setChangeHooks(listener: ChangeHookListener) {
+        val ref = StableRef.create(CallbackContext(listener, logger))
+        val context = ref.asCPointer()
+        sqlite3_update_hook(dbPointer, updateHookCallback, context)
+        sqlite3_commit_hook(dbPointer, commitHookCallback, context)
+        sqlite3_rollback_hook(dbPointer, rollbackHookCallback, context)
+        changeHookRef?.dispose()
+        changeHookRef = ref
+    }
+
+    val readOnly: Boolean
+        get() = sqlite3_db_readonly(dbPointer, "main") == 1
+
+    /**
+     * Bumped by [interrupt], so busy retry loops, which sqlite3_interrupt can't reach, can notice it.
+     */
+    val interruptCount = AtomicInt(0)
+
+    /**
+     * Aborts running statements with SQLITE_INTERRUPT. The only call that's safe from another thread, as long as the
+     * connection isn't closed concurrently.
+     */
+    fun interrupt() {
+        interruptCount.incrementAndGet()
+        sqlite3_interrupt(dbPointer)
+    }
+
+    private var deadlineRef: StableRef<CallbackContext<Deadline>>? = null
+
+    /**
+     * getTimeNanos value after which running statements are aborted, or 0 for none.
+     */
+    var deadlineNanos: Long = 0L
+        private set
+
+    /**
+     * True if the progress handler has aborted a statement because [deadlineNanos] passed.
+     */
+    val deadlineExpired: Boolean
+        get() = deadlineNanos != 0L && deadlineRef?.get()?.target?.expired == true
+
+    /**
+     * Sets or, with 0, clears the deadline. The progress handler is only registered while there is one, so it costs
+     * nothing otherwise.
+     */
+    fun setDeadline(nanos: Long) {
+        if (nanos == 0L) {
+            sqlite3_progress_handler(dbPointer, 0, null, null)
+        } else {
+            val ref = deadlineRef ?: StableRef.create(CallbackContext(Deadline(), logger)).also { deadlineRef = it }
+            ref.get().target.let {
+                it.nanos = nanos
+                it.expired = false
+            }
+            sqlite3_progress_handler(dbPointer, DEADLINE_CHECK_INSTRUCTIONS, progressCallback, ref.asCPointer())
+        }
+        deadlineNanos = nanos
+    }
+
     fun rawExecSql(sqlString: String){
         val err = sqlite3_exec(dbPointer, sqlString, null, null, null)
         if (err != SQLITE_OK) {
             val error = sqlite3_errmsg(dbPointer)?.toKString()
-            throw sqlException(logger, config, "error rawExecSql: $sqlString, ${error?:""}", err)
+            throw sqlException(logger, config, "error rawExecSql: $sqlString, ${error?:""}", err, deadlineExpired)
         }
     }
 
     fun close(){
         logger.v { "close $config" }
 
+        if (traceRef != null) {
+            sqlite3_trace_v2(dbPointer, 0u, null, null)
+            traceRef.dispose()
+        }
+
+        walHookRef?.let {
+            sqlite3_wal_hook(dbPointer, null, null)
+            it.dispose()
+        }
+        walHookRef = null
+
+        changeHookRef?.let {
+            sqlite3_update_hook(dbPointer, null, null)
+            sqlite3_commit_hook(dbPointer, null, null)
+            sqlite3_rollback_hook(dbPointer, null, null)
+            it.dispose()
+        }
+        changeHookRef = null
+
+        deadlineRef?.let {
+            sqlite3_progress_handler(dbPointer, 0, null, null)
+            it.dispose()
+        }
+        deadlineRef = null
+
         val err = sqlite3_close_v2(dbPointer)
         if (err != SQLITE_OK) {
             // This can happen if sub-objects aren't closed first.  Make sure the caller knows.
@@ -56,14 +220,59 @@ internal class SqliteDatabase(path: String, label: String, val logger: Logger, p
     }
 }
 
+internal interface WalHookListener {
+    /**
+     * Called on the committing thread, after a commit to a WAL database, with the number of pages now in the WAL.
+     */
+    fun onWalCommit(walPages: Int)
+}
+
+internal interface ChangeHookListener {
+    /**
+     * A row was inserted, updated or deleted. The strings belong to sqlite and are only valid during the call.
+     */
+    fun onChange(database: CPointer<ByteVar>?, table: CPointer<ByteVar>?)
+
+    /**
+     * A transaction is about to commit. It can still fail, for example with SQLITE_BUSY, and stay open.
+     */
+    fun onCommit()
+
+    fun onRollback()
+}
+
+internal enum class CheckpointMode(val sqliteMode: Int) {
+    PASSIVE(SQLITE_CHECKPOINT_PASSIVE),
+    RESTART(SQLITE_CHECKPOINT_RESTART),
+    TRUNCATE(SQLITE_CHECKPOINT_TRUNCATE)
+}
+
+/**
+ * The context pointer passed to the static sqlite callbacks below: the object the callback is for, and the
+ * connection's logger. Exceptions can't propagate back through sqlite, so the callbacks log them there.
+ */
+internal class CallbackContext<T : Any>(val target: T, val logger: Logger)
+
+internal class Deadline {
+    var nanos = 0L
+    var expired = false
+}
+
+//How many VM instructions run between deadline checks. Cheap enough to be invisible, often enough to stop within
+//well under a millisecond.
+private const val DEADLINE_CHECK_INSTRUCTIONS = 1000
+
+internal class WalCheckpoint(val busy: Boolean, val logFrames: Int, val checkpointedFrames: Int)
+
 internal data class SqliteDatabaseConfig(val path:String, val label:String)
 
 internal enum class OpenFlags {
     CREATE_IF_NECESSARY,
-    OPEN_READONLY
+    OPEN_READONLY,
+    NO_MUTEX,
+    FULL_MUTEX
 }
 
-@Suppress("UNUSED_PARAMETER")
 internal fun dbOpen(
     path: String,
     openFlags: List<OpenFlags>,
@@ -74,7 +283,10 @@ internal fun dbOpen(
     lookasideSlotCount: Int,
     busyTimeout: Int,
     logging: Logger,
-    verboseDataCalls: Boolean
+    verboseDataCalls: Boolean,
+    traceListener: SqlTraceListener? = null,
+    busyStrategy: BusyStrategy = BusyStrategy.FixedDelay(),
+    busyCounters: BusyCounters? = null
 ): SqliteDatabase {
 
     val sqliteFlags = if (openFlags.contains(OpenFlags.CREATE_IF_NECESSARY)) {
@@ -86,9 +298,18 @@ internal fun dbOpen(
     } or SQLITE_OPEN_URI // This ensures that regardless of how sqlite was compiled it will support uri file paths.
 // this is important for using in memory databases.
 
+    // SQLITE_OPEN_NOMUTEX skips sqlite's per-connection mutex. Only safe when the caller guarantees one thread at a time.
+    val threadingFlag = if (openFlags.contains(OpenFlags.NO_MUTEX)) {
+        SQLITE_OPEN_NOMUTEX
+    } else if (openFlags.contains(OpenFlags.FULL_MUTEX)) {
+        SQLITE_OPEN_FULLMUTEX
+    } else {
+        0
+    }
+
     val db = memScoped {
         val dbPtr = alloc<CPointerVar<sqlite3>>()
-        val openResult = sqlite3_open_v2(path, dbPtr.ptr, sqliteFlags, null)
+        val openResult = sqlite3_open_v2(path, dbPtr.ptr, sqliteFlags or threadingFlag, null)
         if (openResult != SQLITE_OK) {
             throw sqlException(logging, SqliteDatabaseConfig(path, label), sqlite3_errmsg(dbPtr.value)?.toKString() ?: "", openResult)
         }
@@ -117,18 +338,92 @@ internal fun dbOpen(
         throw sqlException(logging, SqliteDatabaseConfig(path, label), "Could not set busy timeout", err)
     }
 
-    /*// Create wrapper object.
-    SQLiteConnection* connection = new SQLiteConnection(db, openFlags, path, label);
-
-    // Enable tracing and profiling if requested.
+    // Enable tracing and profiling if requested. Nothing is registered otherwise, so there's no cost when off.
+    var traceMask = 0
     if (enableTrace) {
-        sqlite3_trace_v2(db, SQLITE_TRACE_STMT, &sqliteTraceV2Callback, connection);
+        traceMask = traceMask or SQLITE_TRACE_STMT
     }
     if (enableProfile) {
-        sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, &sqliteTraceV2Callback, connection);
-    }*/
+        traceMask = traceMask or SQLITE_TRACE_PROFILE
+    }
+    val traceRef = if (traceMask != 0) {
+        StableRef.create(CallbackContext(traceListener ?: LoggerTraceListener(logging), logging))
+    } else {
+        null
+    }
+    if (traceRef != null) {
+        sqlite3_trace_v2(db, traceMask.toUInt(), traceCallback, traceRef.asCPointer())
+    }
 
     logging.v { "dbOpen path [$path] label [$label] ${SqliteDatabaseConfig(path, label)}" }
 
-    return SqliteDatabase(path, label, logging, verboseDataCalls, db)
-}
\ No newline at end of file
+    return SqliteDatabase(path, label, logging, verboseDataCalls, db, traceRef, busyStrategy, busyCounters)
+}
+
+/**
+ * Runs [block] with the callback target behind [context]. Anything it throws is logged, and [failed] is returned to
+ * sqlite instead.
+ */
+private inline fun <reified T : Any, R> callbackTarget(context: COpaquePointer?, name: String, failed: R, block: (T) -> R): R {
+    val callbackContext = context!!.asStableRef<CallbackContext<T>>().get()
+    return try {
+        block(callbackContext.target)
+    } catch (e: Throwable) {
+        callbackContext.logger.e(e) { "sqlite $name callback failed" }
+        failed
+    }
+}
+
+private val traceCallback = staticCFunction { mask: UInt, context: COpaquePointer?, p: COpaquePointer?, x: COpaquePointer? ->
+    callbackTarget<SqlTraceListener, Int>(context, "trace", 0) { listener ->
+        when (mask.toInt()) {
+            SQLITE_TRACE_STMT -> {
+                listener.onStatement(x?.reinterpret<ByteVar>()?.let { bytesToString(it) } ?: "")
+            }
+            SQLITE_TRACE_PROFILE -> {
+                val sql = sqlite3_sql(p?.reinterpret<sqlite3_stmt>())?.let { bytesToString(it) } ?: ""
+                listener.onProfile(sql, x!!.reinterpret<LongVar>().pointed.value)
+            }
+        }
+        0
+    }
+}
+
+private val walHookCallback = staticCFunction { context: COpaquePointer?, _: CPointer<sqlite3>?, _: CPointer<ByteVar>?, pages: Int ->
+    callbackTarget<WalHookListener, Int>(context, "wal hook", SQLITE_OK) { listener ->
+        listener.onWalCommit(pages)
+        SQLITE_OK
+    }
+}
+
+private val progressCallback = staticCFunction { context: COpaquePointer? ->
+    // Non-zero aborts the running statement. A failing check lets it continue.
+    callbackTarget<Deadline, Int>(context, "progress", 0) { deadline ->
+        if (getTimeNanos() >= deadline.nanos) {
+            deadline.expired = true
+            1
+        } else {
+            0
+        }
+    }
+}
+
+private val updateHookCallback = staticCFunction { context: COpaquePointer?, _: Int, database: CPointer<ByteVar>?, table: CPointer<ByteVar>?, _: Long ->
+    callbackTarget<ChangeHookListener, Unit>(context, "update hook", Unit) { listener ->
+        listener.onChange(database, table)
+    }
+}
+
+private val commitHookCallback = staticCFunction { context: COpaquePointer? ->
+    // Non-zero would turn the commit into a rollback
+    callbackTarget<ChangeHookListener, Int>(context, "commit hook", 0) { listener ->
+        listener.onCommit()
+        0
+    }
+}
+
+private val rollbackHookCallback = staticCFunction { context: COpaquePointer? ->
+    callbackTarget<ChangeHookListener, Unit>(context, "rollback hook", Unit) { listener ->
+        listener.onRollback()
+    }
+}
@@ -0,0 +1,212 @@
+package co.touchlab.sqliter.interop
+
+import cnames.structs.sqlite3_context
+import cnames.structs.sqlite3_value
+import co.touchlab.sqliter.FieldType
+import co.touchlab.sqliter.SqlAggregate
+import co.touchlab.sqliter.SqlArguments
+import co.touchlab.sqliter.SqlFunction
+import co.touchlab.sqliter.SqlResult
+import co.touchlab.sqliter.SqlWindowAggregate
+import kotlinx.cinterop.*
+import co.touchlab.sqliter.sqlite3.*
+
+/**
+ * Registers [function] on this connection, replacing any function with the same name and argument count. The
+ * registration holds a StableRef, which sqlite releases through the destroy callback when the function is replaced or
+ * the connection closes.
+ */
+internal fun SqliteDatabase.createFunction(function: SqlFunction) {
+    var flags = SQLITE_UTF8
+    if (function.deterministic)
+        flags = flags or SQLITE_DETERMINISTIC
+    if (function.innocuous)
+        flags = flags or SQLITE_INNOCUOUS
+
+    val app = StableRef.create(FunctionCall(function)).asCPointer()
+    // On failure sqlite has already called destroyCallback, so there's nothing to dispose here
+    val err = when (function) {
+        is SqlFunction.Scalar -> sqlite3_create_function_v2(
+            dbPointer, function.name, function.argCount, flags, app,
+            scalarCallback, null, null, destroyCallback
+        )
+        is SqlFunction.Aggregate -> sqlite3_create_function_v2(
+            dbPointer, function.name, function.argCount, flags, app,
+            null, stepCallback, finalCallback, destroyCallback
+        )
+        is SqlFunction.Window -> sqlite3_create_window_function(
+            dbPointer, function.name, function.argCount, flags, app,
+            stepCallback, finalCallback, valueCallback, inverseCallback, destroyCallback
+        )
+    }
+
+    if (err != SQLITE_OK) {
+        val error = sqlite3_errmsg(dbPointer)?.toKString()
+        throw sqlException(logger, config, "error registering function ${function.name}/${function.argCount} ${error ?: ""}", err)
+    }
+
+    logger.v { "createFunction ${function.name}/${function.argCount} on $config" }
+}
+
+/**
+ * Arguments and result for calls to one registered function. The same instance is reused for every call, so reading
+ * arguments and setting results goes straight to sqlite without allocating. Connections are only used by one thread
+ * at a time, and nested calls (a function running SQL that calls it again) save and restore the outer call.
+ */
+internal class FunctionCall(val function: SqlFunction) : SqlArguments, SqlResult {
+    internal var context: CPointer<sqlite3_context>? = null
+    internal var argv: CPointer<CPointerVar<sqlite3_value>>? = null
+
+    override var size: Int = 0
+        internal set
+
+    private fun value(index: Int): CPointer<sqlite3_value>? {
+        if (index < 0 || index >= size)
+            throw IndexOutOfBoundsException("Argument $index, ${function.name} was called with $size")
+        return argv!![index]
+    }
+
+    override fun isNull(index: Int): Boolean = sqlite3_value_type(value(index)) == SQLITE_NULL
+
+    override fun getType(index: Int): FieldType = FieldType.forCode(sqlite3_value_type(value(index)))
+
+    override fun getLong(index: Int): Long = sqlite3_value_int64(value(index))
+
+    override fun getDouble(index: Int): Double = sqlite3_value_double(value(index))
+
+    override fun getString(index: Int): String =
+        sqlite3_value_text(value(index))?.reinterpret<ByteVar>()?.let { bytesToString(it) } ?: ""
+
+    override fun getBytes(index: Int): ByteArray {
+        val value = value(index)
+        // Read the pointer before the size, as sqlite recommends, in case it has to convert the value
+        val blob = sqlite3_value_blob(value)
+        val size = sqlite3_value_bytes(value)
+        return if (blob == null || size <= 0) ByteArray(0) else blob.readBytes(size)
+    }
+
+    override fun setNull() {
+        sqlite3_result_null(context)
+    }
+
+    override fun setLong(value: Long) {
+        sqlite3_result_int64(context, value)
+    }
+
+    override fun setDouble(value: Double) {
+        sqlite3_result_double(context, value)
+    }
+
+    override fun setString(value: String) {
+        sqlite3_result_text(context, value, -1, SQLITE_TRANSIENT)
+    }
+
+    override fun setBytes(value: ByteArray) {
+        if (value.isEmpty()) {
+            sqlite3_result_zeroblob(context, 0)
+        } else {
+            sqlite3_result_blob(context, value.refTo(0), value.size, SQLITE_TRANSIENT)
+        }
+    }
+
+    override fun setError(message: String) {
+        sqlite3_result_error(context, message, -1)
+    }
+
+    fun newAggregate(): SqlAggregate = when (function) {
+        is SqlFunction.Aggregate -> function.factory()
+        is SqlFunction.Window -> function.factory()
+        is SqlFunction.Scalar -> throw IllegalStateException("${function.name} is not an aggregate")
+    }
+}
+
+/**
+ * Points [call] at the current arguments while [block] runs. Exceptions can't propagate back through sqlite, so they
+ * become the statement's error instead.
+ */
+private inline fun onCall(
+    ctx: CPointer<sqlite3_context>?,
+    argc: Int,
+    argv: CPointer<CPointerVar<sqlite3_value>>?,
+    block: FunctionCall.() -> Unit
+) {
+    val call = sqlite3_user_data(ctx)!!.asStableRef<FunctionCall>().get()
+    val outerContext = call.context
+    val outerArgv = call.argv
+    val outerSize = call.size
+    call.context = ctx
+    call.argv = argv
+    call.size = argc
+    try {
+        call.block()
+    } catch (e: Throwable) {
+        sqlite3_result_error(ctx, e.message ?: e.toString(), -1)
+    } finally {
+        call.context = outerContext
+        call.argv = outerArgv
+        call.size = outerSize
+    }
+}
+
+/**
+ * The accumulator for the current group, kept as a StableRef in sqlite's per-group aggregate context. Returns null if
+ * [create] is false and the group has no rows yet.
+ */
+private fun FunctionCall.aggregateRef(ctx: CPointer<sqlite3_context>?, create: Boolean): StableRef<SqlAggregate>? {
+    val slot = sqlite3_aggregate_context(ctx, if (create) sizeOf<COpaquePointerVar>().toInt() else 0)
+        ?.reinterpret<COpaquePointerVar>()
+    if (slot == null) {
+        if (create)
+            sqlite3_result_error_nomem(ctx)
+        return null
+    }
+
+    slot.pointed.value?.let { return it.asStableRef() }
+    if (!create)
+        return null
+
+    val ref = StableRef.create(newAggregate())
+    slot.pointed.value = ref.asCPointer()
+    return ref
+}
+
+private val scalarCallback = staticCFunction { ctx: CPointer<sqlite3_context>?, argc: Int, argv: CPointer<CPointerVar<sqlite3_value>>? ->
+    onCall(ctx, argc, argv) {
+        val scalar = function as SqlFunction.Scalar
+        scalar.function.invoke(this, this)
+    }
+}
+
+private val stepCallback = staticCFunction { ctx: CPointer<sqlite3_context>?, argc: Int, argv: CPointer<CPointerVar<sqlite3_value>>? ->
+    onCall(ctx, argc, argv) {
+        aggregateRef(ctx, true)?.get()?.step(this)
+    }
+}
+
+private val inverseCallback = staticCFunction { ctx: CPointer<sqlite3_context>?, argc: Int, argv: CPointer<CPointerVar<sqlite3_value>>? ->
+    onCall(ctx, argc, argv) {
+        (aggregateRef(ctx, true)?.get() as SqlWindowAggregate?)?.inverse(this)
+    }
+}
+
+private val valueCallback = staticCFunction { ctx: CPointer<sqlite3_context>? ->
+    onCall(ctx, 0, null) {
+        (aggregateRef(ctx, false)?.get() ?: newAggregate()).result(this)
+    }
+}
+
+private val finalCallback = staticCFunction { ctx: CPointer<sqlite3_context>? ->
+    onCall(ctx, 0, null) {
+        val ref = aggregateRef(ctx, false)
+        try {
+            (ref?.get() ?: newAggregate()).result(this)
+        } finally {
+            ref?.dispose()
+        }
+    }
+}
+
+private val destroyCallback = staticCFunction { app: COpaquePointer? ->
+    app?.asStableRef<FunctionCall>()?.dispose()
+    Unit
+}
@@ -1,5 +1,9 @@
 package co.touchlab.sqliter.interop
 
+import co.touchlab.sqliter.StatementStats
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+
 internal interface SqliteStatement {
     //Cursor methods
     fun isNull(index: Int): Boolean
@@ -7,6 +11,9 @@ internal interface SqliteStatement {
     fun columnGetDouble(columnIndex: Int): Double
     fun columnGetString(columnIndex: Int): String
     fun columnGetBlob(columnIndex: Int): ByteArray
+    fun columnBlobPointer(columnIndex: Int): CPointer<ByteVar>?
+    fun columnTextPointer(columnIndex: Int): CPointer<ByteVar>?
+    fun columnBytes(columnIndex: Int): Int
     fun columnCount(): Int
     fun columnName(columnIndex: Int): String
     fun columnType(columnIndex: Int): Int
@@ -25,7 +32,15 @@ internal interface SqliteStatement {
     fun bindDouble(index: Int, value: Double)
     fun bindString(index: Int, value: String)
     fun bindBlob(index: Int, value: ByteArray)
+    fun bindZeroBlob(index: Int, size: Int)
     fun executeNonQuery(): Int
+    fun stats(reset: Boolean): StatementStats
+
+    /**
+     * SQLITE_STMTSTATUS_REPREPARE, without resetting it. Changes when a schema change made sqlite recompile the
+     * statement.
+     */
+    fun reprepareCount(): Int
 
     fun traceLogCallback(message:String)
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 package co.touchlab.sqliter.interop
 
+import co.touchlab.sqliter.StatementStats
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+
 internal class TracingSqliteStatement(private val logger: Logger, private val delegate:SqliteStatement):SqliteStatement {
     private fun <T> logWrapper(name:String, params: List<Any?>, block:()->T):T{
         val result = block()
@@ -12,6 +16,9 @@ internal class TracingSqliteStatement(private val logger: Logger, private val de
     override fun columnGetDouble(columnIndex: Int): Double = logWrapper("columnGetDouble", listOf(columnIndex)) {delegate.columnGetDouble(columnIndex)}
     override fun columnGetString(columnIndex: Int): String = logWrapper("columnGetString", listOf(columnIndex)) {delegate.columnGetString(columnIndex)}
     override fun columnGetBlob(columnIndex: Int): ByteArray  = logWrapper("columnGetBlob", listOf(columnIndex)) {delegate.columnGetBlob(columnIndex)}
+    override fun columnBlobPointer(columnIndex: Int): CPointer<ByteVar>? = logWrapper("columnBlobPointer", listOf(columnIndex)) {delegate.columnBlobPointer(columnIndex)}
+    override fun columnTextPointer(columnIndex: Int): CPointer<ByteVar>? = logWrapper("columnTextPointer", listOf(columnIndex)) {delegate.columnTextPointer(columnIndex)}
+    override fun columnBytes(columnIndex: Int): Int = logWrapper("columnBytes", listOf(columnIndex)) {delegate.columnBytes(columnIndex)}
     override fun columnCount(): Int  = logWrapper("columnCount", emptyList()) {delegate.columnCount()}
     override fun columnName(columnIndex: Int): String  = logWrapper("columnName", listOf(columnIndex)) {delegate.columnName(columnIndex)}
     override fun columnType(columnIndex: Int): Int  = logWrapper("columnType", listOf(columnIndex)) {delegate.columnType(columnIndex)}
@@ -28,7 +35,10 @@ internal class TracingSqliteStatement(private val logger: Logger, private val de
     override fun bindDouble(index: Int, value: Double)= logWrapper("bindDouble", listOf(index, value)) {delegate.bindDouble(index, value)}
     override fun bindString(index: Int, value: String)  = logWrapper("bindString", listOf(index, value)) {delegate.bindString(index, value)}
     override fun bindBlob(index: Int, value: ByteArray)  = logWrapper("bindBlob", listOf(index, value)) {delegate.bindBlob(index, value)}
+    override fun bindZeroBlob(index: Int, size: Int)  = logWrapper("bindZeroBlob", listOf(index, size)) {delegate.bindZeroBlob(index, size)}
     override fun executeNonQuery(): Int = logWrapper("executeNonQuery", emptyList()) {delegate.executeNonQuery()}
+    override fun stats(reset: Boolean): StatementStats = logWrapper("stats", listOf(reset)) {delegate.stats(reset)}
+    override fun reprepareCount(): Int = logWrapper("reprepareCount", emptyList()) {delegate.reprepareCount()}
     override fun traceLogCallback(message: String) {
         logger.vWrite(message)
         delegate.traceLogCallback(message)
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.CheckpointStats
+import co.touchlab.sqliter.concurrency.Condition
+import co.touchlab.sqliter.concurrency.withLock
+import co.touchlab.sqliter.interop.CheckpointMode
+import co.touchlab.sqliter.interop.Logger
+import co.touchlab.sqliter.interop.WalHookListener
+import co.touchlab.sqliter.interop.e
+import kotlin.native.concurrent.Worker
+import kotlin.system.getTimeNanos
+
+/**
+ * Runs WAL checkpoints on a background thread instead of inline on the commit that crosses the autocheckpoint
+ * threshold. Writable connections report the WAL size through sqlite3_wal_hook after each commit. Once it reaches
+ * [walPages], the worker runs a PASSIVE checkpoint on its own connection. If readers keep the WAL from being reset and
+ * it keeps growing, checkpoints escalate to RESTART, then TRUNCATE, which wait for readers using the busy handler.
+ *
+ * The worker and its connection only exist while at least one writable connection from the manager is open.
+ */
+internal class CheckpointScheduler(
+    private val manager: NativeDatabaseManager,
+    private val walPages: Int,
+    private val logger: Logger
+) : WalHookListener {
+    //Guards everything below
+    private val condition = Condition()
+    private var openConnections = 0
+    private var worker: Worker? = null
+
+    //Incremented to tell the current worker to stop
+    private var generation = 0
+    private var requested = false
+
+    private var latestWalPages = 0
+    private var maxWalPages = 0
+    private var passive = 0L
+    private var restart = 0L
+    private var truncate = 0L
+    private var busy = 0L
+    private var failures = 0L
+    private var totalNanos = 0L
+    private var maxNanos = 0L
+
+    fun attach(connection: NativeDatabaseConnection) {
+        connection.scheduleCheckpoints(this)
+        condition.withLock {
+            openConnections++
+            if (worker == null) {
+                val runGeneration = generation
+                worker = Worker.start(name = "sqliter-checkpoint").also {
+                    it.executeAfter(0L) { runCheckpoints(runGeneration) }
+                }
+            }
+        }
+    }
+
+    fun detach() {
+        val stopping = condition.withLock {
+            openConnections--
+            if (openConnections > 0)
+                return
+
+            generation++
+            condition.signalAll()
+            worker.also { worker = null }
+        }
+
+        //Waits for a checkpoint in progress, and for the worker to close its connection
+        stopping?.requestTermination()?.result
+    }
+
+    override fun onWalCommit(walPages: Int) {
+        condition.withLock {
+            latestWalPages = walPages
+            if (walPages > maxWalPages)
+                maxWalPages = walPages
+            if (walPages >= this.walPages) {
+                requested = true
+                condition.signalAll()
+            }
+        }
+    }
+
+    fun stats(): CheckpointStats = condition.withLock {
+        CheckpointStats(
+            passive = passive,
+            restart = restart,
+            truncate = truncate,
+            busy = busy,
+            failures = failures,
+            walPages = latestWalPages,
+            maxWalPages = maxWalPages,
+            totalNanos = totalNanos,
+            maxNanos = maxNanos
+        )
+    }
+
+    private fun runCheckpoints(runGeneration: Int) {
+        var connection: NativeDatabaseConnection? = null
+        try {
+            while (true) {
+                val pages = condition.withLock {
+                    while (!requested && generation == runGeneration) {
+                        condition.await()
+                    }
+                    requested = false
+                    if (generation == runGeneration) latestWalPages else -1
+                }
+                if (pages < 0)
+                    break
+
+                val conn = connection ?: manager.createInternalConnection().also { connection = it }
+                checkpoint(conn, pages)
+            }
+        } catch (e: Exception) {
+            logger.e(e) { "Background checkpoints stopped" }
+        } finally {
+            connection?.close()
+        }
+    }
+
+    private fun checkpoint(connection: NativeDatabaseConnection, pages: Int) {
+        val mode = when {
+            pages >= walPages * TRUNCATE_FACTOR -> CheckpointMode.TRUNCATE
+            pages >= walPages * RESTART_FACTOR -> CheckpointMode.RESTART
+            else -> CheckpointMode.PASSIVE
+        }
+
+        val start = getTimeNanos()
+        val result = try {
+            connection.checkpoint(mode)
+        } catch (e: Exception) {
+            logger.e(e) { "Background ${mode.name} checkpoint failed" }
+            null
+        }
+        val elapsed = getTimeNanos() - start
+
+        condition.withLock {
+            when {
+                result == null -> failures++
+                mode == CheckpointMode.PASSIVE -> passive++
+                mode == CheckpointMode.RESTART -> restart++
+                else -> truncate++
+            }
+            if (result?.busy == true)
+                busy++
+            totalNanos += elapsed
+            if (elapsed > maxNanos)
+                maxNanos = elapsed
+        }
+    }
+
+    private companion object {
+        const val RESTART_FACTOR = 4
+        const val TRUNCATE_FACTOR = 16
+    }
+}
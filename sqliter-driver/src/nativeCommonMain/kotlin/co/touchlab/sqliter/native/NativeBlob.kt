@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.Blob
+import co.touchlab.sqliter.interop.SqliteBlob
+
+class NativeBlob internal constructor(
+    private val sqliteBlob: SqliteBlob,
+    override val writable: Boolean
+) : Blob {
+    private var closed = false
+
+    override val size: Int
+        get() {
+            checkOpen()
+            return sqliteBlob.size
+        }
+
+    override fun read(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) {
+        checkOpen()
+        checkRange(buffer, bufferOffset, length)
+        if (length > 0) {
+            sqliteBlob.read(offset, buffer, bufferOffset, length)
+        }
+    }
+
+    override fun write(offset: Int, buffer: ByteArray, bufferOffset: Int, length: Int) {
+        checkOpen()
+        checkRange(buffer, bufferOffset, length)
+        if (length > 0) {
+            sqliteBlob.write(offset, buffer, bufferOffset, length)
+        }
+    }
+
+    override fun reopen(rowId: Long) {
+        checkOpen()
+        sqliteBlob.reopen(rowId)
+    }
+
+    override fun close() {
+        if (!closed) {
+            closed = true
+            sqliteBlob.close()
+        }
+    }
+
+    //The sqlite3_blob is freed on close, so using it after that isn't an error sqlite can report
+    private fun checkOpen() {
+        if (closed)
+            throw IllegalStateException("Blob is closed")
+    }
+
+    //sqlite checks the blob side. The buffer side is on us, as refTo doesn't know the length.
+    private fun checkRange(buffer: ByteArray, bufferOffset: Int, length: Int) {
+        if (bufferOffset < 0 || length < 0 || bufferOffset > buffer.size - length) {
+            throw IndexOutOfBoundsException("bufferOffset $bufferOffset, length $length, buffer size ${buffer.size}")
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.ConnectionPool
+import co.touchlab.sqliter.DatabaseConnection
+import co.touchlab.sqliter.concurrency.Condition
+import co.touchlab.sqliter.concurrency.withLock
+
+internal class NativeConnectionPool(
+    manager: NativeDatabaseManager,
+    readerCount: Int
+) : ConnectionPool {
+    //The writer is opened first, so migrations run before any reader connects
+    private val writer = FairConnectionQueue(1) { manager.createConnection() }.apply { release(acquire()) }
+
+    private val readers = if (readerCount > 0 && !manager.isEphemeral) {
+        FairConnectionQueue(readerCount) { manager.createConnection(readOnly = true) }
+    } else {
+        writer
+    }
+
+    override fun <R> read(block: (DatabaseConnection) -> R): R = readers.use(block)
+
+    override fun <R> write(block: (DatabaseConnection) -> R): R = writer.use(block)
+
+    override fun close() {
+        writer.close()
+        if (readers !== writer)
+            readers.close()
+    }
+}
+
+/**
+ * Hands out up to [maxConnections] connections, opening them on demand. Callers take a ticket and are served
+ * strictly in ticket order, so a steady stream of new callers can't starve one that's been waiting.
+ */
+internal class FairConnectionQueue(
+    private val maxConnections: Int,
+    private val factory: () -> DatabaseConnection
+) {
+    private val condition = Condition()
+    private val idle = ArrayList<DatabaseConnection>(maxConnections)
+    private var openCount = 0
+    private var nextTicket = 0L
+    private var nowServing = 0L
+    private var closed = false
+
+    inline fun <R> use(block: (DatabaseConnection) -> R): R {
+        val connection = acquire()
+        try {
+            return block(connection)
+        } finally {
+            release(connection)
+        }
+    }
+
+    fun acquire(): DatabaseConnection {
+        //Either an idle connection, or null with a slot reserved in openCount to open one outside the lock
+        val idleConnection = condition.withLock {
+            val ticket = nextTicket++
+            try {
+                var connection: DatabaseConnection? = null
+                var reserved = false
+                while (connection == null && !reserved) {
+                    if (closed)
+                        throw IllegalStateException("Connection pool is closed")
+
+                    if (ticket == nowServing) {
+                        if (idle.isNotEmpty()) {
+                            connection = idle.removeAt(idle.size - 1)
+                        } else if (openCount < maxConnections) {
+                            openCount++
+                            reserved = true
+                        }
+                    }
+
+                    if (connection == null && !reserved)
+                        condition.await()
+                }
+                connection
+            } finally {
+                //Whether we got a connection, a slot, or failed, the next ticket is up
+                if (ticket == nowServing)
+                    nowServing++
+                condition.signalAll()
+            }
+        }
+
+        return idleConnection ?: open()
+    }
+
+    //Opening can be slow (migrations, keys, pragmas), so other callers keep being served meanwhile
+    private fun open(): DatabaseConnection {
+        val connection = try {
+            factory()
+        } catch (e: Exception) {
+            condition.withLock {
+                openCount--
+                condition.signalAll()
+            }
+            throw e
+        }
+
+        val closedMeanwhile = condition.withLock {
+            if (closed) {
+                openCount--
+                condition.signalAll()
+            }
+            closed
+        }
+        if (closedMeanwhile) {
+            connection.close()
+            throw IllegalStateException("Connection pool is closed")
+        }
+        return connection
+    }
+
+    fun release(connection: DatabaseConnection) {
+        condition.withLock {
+            if (closed) {
+                openCount--
+                connection.close()
+            } else {
+                idle.add(connection)
+            }
+            condition.signalAll()
+        }
+    }
+
+    fun close() {
+        condition.withLock {
+            closed = true
+            idle.forEach {
+                openCount--
+                it.close()
+            }
+            idle.clear()
+            condition.signalAll()
+        }
+    }
+}
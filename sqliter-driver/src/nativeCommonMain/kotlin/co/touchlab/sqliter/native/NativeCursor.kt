@@ -16,8 +16,15 @@
 
 package co.touchlab.sqliter.native
 
+import co.touchlab.sqliter.ColumnChunk
 import co.touchlab.sqliter.Cursor
 import co.touchlab.sqliter.FieldType
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.addressOf
+import kotlinx.cinterop.convert
+import kotlinx.cinterop.usePinned
+import platform.posix.memcpy
 
 class NativeCursor(override val statement: NativeStatement) : Cursor {
     override fun next(): Boolean {
@@ -28,28 +35,77 @@ class NativeCursor(override val statement: NativeStatement) : Cursor {
     override fun getLong(index: Int): Long = statement.sqliteStatement.columnGetLong(index)
     override fun getBytes(index: Int): ByteArray = statement.sqliteStatement.columnGetBlob(index)
     override fun getDouble(index: Int): Double = statement.sqliteStatement.columnGetDouble(index)
+
+    override fun <R> withBlob(index: Int, block: (bytes: CPointer<ByteVar>?, size: Int) -> R): R {
+        val sqliteStatement = statement.sqliteStatement
+        // Pointer first, then size. See https://www.sqlite.org/c3ref/column_blob.html
+        val bytes = sqliteStatement.columnBlobPointer(index)
+        return block(bytes, if (bytes == null) 0 else sqliteStatement.columnBytes(index))
+    }
+
+    override fun <R> withText(index: Int, block: (utf8: CPointer<ByteVar>?, size: Int) -> R): R {
+        val sqliteStatement = statement.sqliteStatement
+        val utf8 = sqliteStatement.columnTextPointer(index)
+        return block(utf8, if (utf8 == null) 0 else sqliteStatement.columnBytes(index))
+    }
+
+    override fun getBytesInto(index: Int, dest: ByteArray, offset: Int): Int {
+        if (offset < 0 || offset > dest.size)
+            throw IndexOutOfBoundsException("offset $offset is outside dest of size ${dest.size}")
+        return copyBlobInto(index, dest, offset)
+    }
+
+    private fun copyBlobInto(index: Int, dest: ByteArray, offset: Int): Int = withBlob(index) { bytes, size ->
+        val count = minOf(size, dest.size - offset)
+        if (bytes != null && count > 0) {
+            dest.usePinned { memcpy(it.addressOf(offset), bytes, count.convert()) }
+        }
+        size
+    }
+
     override fun getType(index: Int): FieldType = FieldType.forCode(statement.sqliteStatement.columnType(index))
+
+    override fun getTypes(types: IntArray): Int {
+        val sqliteStatement = statement.sqliteStatement
+        val count = minOf(types.size, sqliteStatement.columnCount())
+        for (i in 0 until count) {
+            types[i] = sqliteStatement.columnType(i)
+        }
+        return count
+    }
+
     override val columnCount: Int
         get() = statement.sqliteStatement.columnCount()
 
     override fun columnName(index: Int): String = statement.sqliteStatement.columnName(index)
 
-    override val columnNames: Map<String, Int> by lazy {
-        val map = HashMap<String, Int>(this.columnCount)
-        for (i in 0 until columnCount) {
-            val key = columnName(i)
-            if (map.containsKey(key)) {
-                var index = 1
-                val basicKey = "$key&JOIN"
-                var finalKey = basicKey + index
-                while (map.containsKey(finalKey)) {
-                    finalKey = basicKey + ++index
+    override fun fetchColumns(chunk: ColumnChunk): Int {
+        val sqliteStatement = statement.sqliteStatement
+        val types = chunk.columnTypes
+        if (types.size > columnCount)
+            throw IllegalArgumentException("Chunk has ${types.size} columns, query has $columnCount")
+
+        chunk.clear()
+        while (chunk.rowCount < chunk.capacity && sqliteStatement.step()) {
+            val row = chunk.rowCount
+            for (col in types.indices) {
+                if (sqliteStatement.isNull(col)) {
+                    chunk.setNull(col, row)
+                } else {
+                    when (types[col]) {
+                        FieldType.TYPE_INTEGER -> chunk.setLong(col, row, sqliteStatement.columnGetLong(col))
+                        FieldType.TYPE_FLOAT -> chunk.setDouble(col, row, sqliteStatement.columnGetDouble(col))
+                        FieldType.TYPE_TEXT -> chunk.setString(col, row, sqliteStatement.columnGetString(col))
+                        FieldType.TYPE_BLOB -> chunk.setBlob(col, row, sqliteStatement.columnGetBlob(col))
+                        FieldType.TYPE_NULL -> chunk.setNull(col, row)
+                    }
                 }
-                map[finalKey] = i
-            } else {
-                map[key] = i
             }
+            chunk.endRow()
         }
-        map
+        return chunk.rowCount
     }
+
+    override val columnNames: Map<String, Int>
+        get() = statement.columnNames
 }
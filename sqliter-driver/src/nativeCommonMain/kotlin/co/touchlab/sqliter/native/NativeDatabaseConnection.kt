@@ -19,69 +19,290 @@ package co.touchlab.sqliter.native
 import co.touchlab.sqliter.*
 import co.touchlab.sqliter.concurrency.Lock
 import co.touchlab.sqliter.concurrency.withLock
+import co.touchlab.sqliter.interop.CheckpointMode
 import co.touchlab.sqliter.interop.SqliteDatabase
 import co.touchlab.sqliter.interop.SqliteDatabasePointer
-import co.touchlab.sqliter.util.maybeFreeze
+import co.touchlab.sqliter.interop.SqliteStatement
+import co.touchlab.sqliter.interop.WalCheckpoint
+import co.touchlab.sqliter.interop.backupTo
+import co.touchlab.sqliter.interop.createFunction
 import kotlin.concurrent.AtomicInt
-import kotlin.concurrent.AtomicReference
+import kotlin.system.getTimeNanos
 
 class NativeDatabaseConnection internal constructor(
     val dbManager: NativeDatabaseManager,
-    private val sqliteDatabase: SqliteDatabase
+    private val sqliteDatabase: SqliteDatabase,
+    //Opened by the library for its own use, so it's never passed to onCloseConnection
+    private val internalConnection: Boolean = false
 ) : DatabaseConnection {
 
     private val transLock = Lock()
 
-    private val transaction = AtomicReference<Transaction?>(null)
+    //Open transaction levels, guarded by transLock. Level 0 is the BEGIN, the rest are savepoints.
+    private var transactionDepth = 0
+    private var levelSuccessful = BooleanArray(4)
+
+    //Transaction control statements, prepared on first use and kept until close
+    private val beginStatements = arrayOfNulls<SqliteStatement>(TransactionMode.values().size)
+    private var commitStatement: SqliteStatement? = null
+    private var rollbackStatement: SqliteStatement? = null
+    private val savepointStatements = LevelStatements { "SAVEPOINT $it;" }
+    private val rollbackToStatements = LevelStatements { "ROLLBACK TO $it;" }
+    private val releaseStatements = LevelStatements { "RELEASE $it;" }
+
     private val closedFlag = AtomicInt(0)
 
-    data class Transaction(val successful: Boolean)
+    //Read-only connections can't take the write lock, so they always use DEFERRED
+    private val defaultTransactionMode = if (sqliteDatabase.readOnly) {
+        TransactionMode.DEFERRED
+    } else {
+        dbManager.configuration.extendedConfig.transactionMode
+    }
+
+    private val statementCache = StatementCache(dbManager.configuration.extendedConfig.statementCacheSize)
 
     override fun rawExecSql(sql: String) {
         sqliteDatabase.rawExecSql(sql)
+        publishTableChanges()
     }
 
     override fun createStatement(sql: String): Statement {
-        val statementPtr = sqliteDatabase.prepareStatement(sql)
+        if (statementCache.enabled) {
+            statementCache.take(sql)?.let { return it }
+        }
+
+        val statementPtr = sqliteDatabase.prepareStatement(sql, persistent = statementCache.enabled)
         val statement = NativeStatement(this, statementPtr, sql)
 
         return statement
     }
 
-    override fun beginTransaction() = transLock.withLock {
-        withStatement("BEGIN;") { execute() }
-        transaction.value = Transaction(false).maybeFreeze()
+    override fun openBlob(table: String, column: String, rowId: Long, writable: Boolean): Blob =
+        NativeBlob(sqliteDatabase.openBlob(table, column, rowId, writable), writable)
+
+    override fun registerFunction(function: SqlFunction) {
+        sqliteDatabase.createFunction(function)
+    }
+
+    /**
+     * Called when a statement is finalized by the caller. If the statement cache is enabled, the statement is reset,
+     * bindings are cleared, and it goes back in the cache. Returns false if the statement should really be finalized.
+     */
+    internal fun recycleStatement(statement: NativeStatement): Boolean {
+        if (closed || !statementCache.enabled)
+            return false
+
+        try {
+            statement.sqliteStatement.resetStatement()
+            statement.sqliteStatement.clearBindings()
+        } catch (e: Exception) {
+            return false
+        }
+
+        return statementCache.put(statement)
+    }
+
+    /**
+     * True if sqlite has a transaction open on this connection, whether or not it was started with beginTransaction.
+     */
+    internal val inTransaction: Boolean
+        get() = sqliteDatabase.inTransaction
+
+    override fun statementCacheStats(): StatementCacheStats = statementCache.stats()
+
+    private val collectStatementStats = dbManager.configuration.loggingConfig.statementMetrics
+    private val statementStats = HashMap<String, StatementStats>()
+
+    /**
+     * Moves a statement's sqlite3_stmt_status counters into the per-SQL totals. Called when the caller is done with
+     * the statement, so a cached statement starts from zero on its next use.
+     */
+    internal fun rollUpStats(statement: NativeStatement) {
+        if (!collectStatementStats || closed)
+            return
+
+        val stats = statement.sqliteStatement.stats(reset = true)
+        val existing = statementStats[statement.sql]
+        statementStats[statement.sql] = if (existing == null) stats else existing + stats
+    }
+
+    override fun statementStats(): Map<String, StatementStats> = HashMap(statementStats)
+
+    /**
+     * Starts a transaction, or if one is already open, a savepoint nested inside it. Each level is ended by its own
+     * endTransaction. An inner level that isn't marked successful rolls back to its savepoint without affecting the
+     * outer levels, and nothing is committed until the outermost level ends successfully.
+     */
+    override fun beginTransaction() = beginTransaction(defaultTransactionMode)
+
+    override fun beginTransaction(mode: TransactionMode) = transLock.withLock {
+        if (transactionDepth == 0) {
+            val begin = beginStatements[mode.ordinal]
+                ?: prepareControlStatement(mode.beginSql).also { beginStatements[mode.ordinal] = it }
+            executeControlStatement(begin)
+        } else {
+            executeControlStatement(savepointStatements[transactionDepth])
+        }
+
+        if (transactionDepth == levelSuccessful.size) {
+            levelSuccessful = levelSuccessful.copyOf(transactionDepth * 2)
+        }
+        levelSuccessful[transactionDepth] = false
+        transactionDepth += 1
     }
 
     override fun setTransactionSuccessful() = transLock.withLock {
-        val trans = checkFailTransaction()
-        transaction.value = trans.copy(successful = true).maybeFreeze()
+        checkInTransaction()
+        levelSuccessful[transactionDepth - 1] = true
     }
 
     override fun endTransaction() = transLock.withLock {
-        val trans = checkFailTransaction()
+        checkInTransaction()
+        val level = transactionDepth - 1
 
         try {
-            withStatement(
-            if(trans.successful){
-                    "COMMIT;"
+            if (!sqliteDatabase.inTransaction) {
+                // sqlite already rolled back, e.g. after an interrupt or some I/O errors. Running COMMIT or ROLLBACK
+                // now would fail and hide the error that caused it, which the caller is already unwinding with.
+                if (level == 0 && levelSuccessful[0])
+                    throw IllegalStateException("Transaction was rolled back by sqlite and can't be committed")
+            } else if (level == 0) {
+                if (levelSuccessful[0]) {
+                    executeControlStatement(commitStatement ?: prepareControlStatement("COMMIT;").also { commitStatement = it })
+                } else {
+                    executeControlStatement(rollbackStatement ?: prepareControlStatement("ROLLBACK;").also { rollbackStatement = it })
+                }
             } else {
-                    "ROLLBACK;"
+                if (!levelSuccessful[level]) {
+                    executeControlStatement(rollbackToStatements[level])
+                }
+                executeControlStatement(releaseStatements[level])
             }
-            ) { execute() }
         } finally {
-            transaction.value = null
+            transactionDepth = level
         }
+
+        if (level == 0)
+            publishTableChanges()
     }
 
-    private fun checkFailTransaction(): Transaction {
-        return transaction.value ?: throw Exception("No transaction")
+    private fun savepointName(depth: Int) = "sqliter_savepoint_$depth"
+
+    /**
+     * One control statement per savepoint level, prepared the first time a transaction nests that deep.
+     */
+    private inner class LevelStatements(private val sql: (savepoint: String) -> String) {
+        private var statements = arrayOfNulls<SqliteStatement>(4)
+
+        operator fun get(level: Int): SqliteStatement {
+            if (level >= statements.size) {
+                statements = statements.copyOf(maxOf(level + 1, statements.size * 2))
+            }
+            return statements[level]
+                ?: prepareControlStatement(sql(savepointName(level))).also { statements[level] = it }
+        }
+
+        fun finalizeAll() {
+            statements.forEach { it?.finalizeStatement() }
+        }
+    }
+
+    private fun checkInTransaction() {
+        if (transactionDepth == 0)
+            throw Exception("No transaction")
+    }
+
+    /**
+     * Prepares a statement that's run with executeControlStatement and kept for the life of the connection. It
+     * bypasses the statement cache and stats, and the caller must finalize it before closing the connection.
+     */
+    internal fun prepareControlStatement(sql: String): SqliteStatement =
+        sqliteDatabase.prepareStatement(sql, persistent = true)
+
+    internal fun executeControlStatement(statement: SqliteStatement) {
+        try {
+            statement.execute()
+        } finally {
+            //sqlite3_reset repeats the error from a failed step, which the execute call has already thrown
+            try {
+                statement.resetStatement()
+            } catch (e: Exception) {
+            }
+        }
+    }
+
+    private fun finalizeControlStatements() {
+        beginStatements.forEach { it?.finalizeStatement() }
+        commitStatement?.finalizeStatement()
+        rollbackStatement?.finalizeStatement()
+        savepointStatements.finalizeAll()
+        rollbackToStatements.finalizeAll()
+        releaseStatements.finalizeAll()
+    }
+
+    private var checkpointScheduler: CheckpointScheduler? = null
+
+    /**
+     * Hands this connection's WAL commits to [scheduler] instead of checkpointing inline.
+     */
+    internal fun scheduleCheckpoints(scheduler: CheckpointScheduler) {
+        sqliteDatabase.setWalHook(scheduler)
+        checkpointScheduler = scheduler
+    }
+
+    //Keeps close from freeing the sqlite handle while another thread is interrupting it
+    private val interruptLock = Lock()
+
+    override fun interrupt() = interruptLock.withLock {
+        if (!closed)
+            sqliteDatabase.interrupt()
+    }
+
+    override fun <R> withDeadline(timeoutMillis: Long, block: (DatabaseConnection) -> R): R {
+        require(timeoutMillis > 0) { "timeoutMillis must be positive" }
+        val outer = sqliteDatabase.deadlineNanos
+        val deadline = getTimeNanos() + timeoutMillis * 1_000_000
+        sqliteDatabase.setDeadline(if (outer != 0L && outer < deadline) outer else deadline)
+        try {
+            return block(this)
+        } finally {
+            if (!closed)
+                sqliteDatabase.setDeadline(outer)
+        }
+    }
+
+    private var tableChangeTracker: TableChangeTracker? = null
+
+    internal fun trackTableChanges() {
+        val tracker = TableChangeTracker(dbManager)
+        sqliteDatabase.setChangeHooks(tracker)
+        tableChangeTracker = tracker
     }
 
+    /**
+     * Hands tables changed by committed transactions to the manager's listeners, once sqlite is back in autocommit
+     * mode. Called after anything that can end a transaction.
+     */
+    internal fun publishTableChanges() {
+        val tracker = tableChangeTracker ?: return
+        if (!tracker.hasCommitted || sqliteDatabase.inTransaction)
+            return
+        dbManager.publishTableChanges(tracker.takeCommitted())
+    }
+
+    internal fun checkpoint(mode: CheckpointMode): WalCheckpoint = sqliteDatabase.checkpoint(mode)
+
+    internal fun backupTo(path: String, pagesPerStep: Int, stepDelayMillis: Int, progress: (remaining: Int, total: Int) -> Unit) =
+        sqliteDatabase.backupTo(path, pagesPerStep, stepDelayMillis, progress)
+
     override fun close() {
-        closedFlag.value = 1
+        interruptLock.withLock { closedFlag.value = 1 }
+        statementCache.clear()
+        finalizeControlStatements()
         sqliteDatabase.close()
-        dbManager.closeConnection(this)
+        if (!internalConnection)
+            dbManager.closeConnection(this)
+        checkpointScheduler?.detach()
     }
 
     override val closed: Boolean
@@ -23,8 +23,10 @@ import co.touchlab.sqliter.concurrency.SingleThreadDatabaseConnection
 import co.touchlab.sqliter.concurrency.withLock
 import co.touchlab.sqliter.interop.OpenFlags
 import co.touchlab.sqliter.interop.dbOpen
+import co.touchlab.sqliter.interop.e
 import co.touchlab.sqliter.util.maybeFreeze
 import kotlin.concurrent.AtomicInt
+import kotlin.concurrent.AtomicReference
 
 class NativeDatabaseManager(private val path:String,
                             override val configuration: DatabaseConfiguration
@@ -37,15 +39,135 @@ class NativeDatabaseManager(private val path:String,
         return SingleThreadDatabaseConnection(createConnection())
     }
 
+    override fun createConnectionPool(): ConnectionPool {
+        return NativeConnectionPool(this, configuration.extendedConfig.readerConnectionCount)
+    }
+
+    override fun createWriteQueue(): WriteQueue {
+        return NativeWriteQueue(
+            this,
+            configuration.extendedConfig.writeQueueMaxBatch,
+            configuration.extendedConfig.writeQueueMaxDelayMillis
+        )
+    }
+
+    /**
+     * "Temporary" and "purely in-memory" databases live only as long as the connection, so they can't be shared.
+     */
+    internal val isEphemeral: Boolean
+        get() = when (path) {
+            "", ":memory:" -> true
+            else -> false
+        }
+
     private val lock = Lock()
 
+    internal val statementMetrics: StatementMetrics? = configuration.loggingConfig.let { logging ->
+        if (logging.statementMetrics || logging.slowStatementThresholdMs >= 0) {
+            StatementMetrics(logging.logger, logging.statementMetrics, logging.slowStatementThresholdMs * 1_000_000)
+        } else {
+            null
+        }
+    }
+
+    private val busyCounters = BusyCounters()
+
+    internal val checkpointScheduler: CheckpointScheduler? = configuration.extendedConfig.let { extended ->
+        if (extended.backgroundCheckpoint && configuration.journalMode == JournalMode.WAL && !configuration.inMemory && !isEphemeral) {
+            CheckpointScheduler(this, extended.walAutoCheckpoint ?: DEFAULT_WAL_AUTOCHECKPOINT, configuration.loggingConfig.logger)
+        } else {
+            null
+        }
+    }
+
+    override fun checkpointStats(): CheckpointStats =
+        checkpointScheduler?.stats() ?: CheckpointStats(0, 0, 0, 0, 0, 0, 0, 0, 0)
+
+    // Every connection we hand out is either locked (ConcurrentDatabaseConnection), confined to one thread
+    // (SingleThreadDatabaseConnection), or checked out to one thread at a time (ConnectionPool). sqlite's own
+    // serialized-mode mutex would just be a second lock around the same calls, so it's off unless configured.
+    private val threadingFlag: OpenFlags = when (configuration.extendedConfig.threadingMode) {
+        ThreadingMode.MULTI_THREAD -> OpenFlags.NO_MUTEX
+        ThreadingMode.SERIALIZED -> OpenFlags.FULL_MUTEX
+    }
+
+    override fun busyStats(): BusyStats = busyCounters.snapshot()
+
+    override fun statementMetrics(): List<StatementLatency> = statementMetrics?.snapshot() ?: emptyList()
+
+    override fun resetStatementMetrics() {
+        statementMetrics?.reset()
+    }
+
+    override fun backupTo(
+        path: String,
+        pagesPerStep: Int,
+        stepDelayMillis: Int,
+        progress: (remaining: Int, total: Int) -> Unit
+    ) {
+        require(pagesPerStep != 0) { "pagesPerStep must not be 0" }
+        require(stepDelayMillis in 0 until 1000) { "stepDelayMillis must be between 0 and 999" }
+        withSourceConnection { it.backupTo(path, pagesPerStep, stepDelayMillis, progress) }
+    }
+
+    override fun vacuumInto(path: String) {
+        withSourceConnection { conn ->
+            conn.withStatement("VACUUM INTO ?") {
+                bindString(1, path)
+                execute()
+            }
+        }
+    }
+
+    /**
+     * A short-lived connection to copy from. Read-only where possible, so it never runs migrations or takes the
+     * write lock. Shared-cache in-memory databases get a regular connection.
+     */
+    private inline fun <R> withSourceConnection(block: (NativeDatabaseConnection) -> R): R {
+        check(!isEphemeral) { "Temporary and purely in-memory databases can't be copied from a new connection" }
+        val conn = createConnection(readOnly = !configuration.inMemory)
+        try {
+            return block(conn)
+        } finally {
+            conn.close()
+        }
+    }
+
+    private val tableChangeListeners = AtomicReference<List<TableChangeListener>>(emptyList())
+
+    internal val hasTableChangeListeners: Boolean
+        get() = tableChangeListeners.value.isNotEmpty()
+
+    override fun addTableChangeListener(listener: TableChangeListener) = lock.withLock {
+        tableChangeListeners.value = tableChangeListeners.value + listener
+    }
+
+    override fun removeTableChangeListener(listener: TableChangeListener) = lock.withLock {
+        tableChangeListeners.value = tableChangeListeners.value - listener
+    }
+
+    internal fun publishTableChanges(tables: Set<String>) {
+        tableChangeListeners.value.forEach { listener ->
+            try {
+                listener.onTablesChanged(tables)
+            } catch (e: Exception) {
+                configuration.loggingConfig.logger.e(e) { "TableChangeListener failed" }
+            }
+        }
+    }
+
     private val newConnection = AtomicInt(0)
 
-    private fun createConnection(): DatabaseConnection {
+    /**
+     * A bare connection for the library's own background work. It only gets the cipher key and busy handling:
+     * no lifecycle callbacks, functions, pragmas, migrations, rekey or change hooks, and it isn't counted as a user
+     * connection.
+     */
+    internal fun createInternalConnection(): NativeDatabaseConnection {
         return lock.withLock {
             val connectionPtrArg = dbOpen(
                 path,
-                listOf(OpenFlags.CREATE_IF_NECESSARY),
+                listOf(threadingFlag),
                 "sqliter",
                 false,
                 false,
@@ -53,9 +175,48 @@ class NativeDatabaseManager(private val path:String,
                 configuration.extendedConfig.lookasideSlotCount,
                 configuration.extendedConfig.busyTimeout,
                 configuration.loggingConfig.logger,
-                configuration.loggingConfig.verboseDataCalls
+                configuration.loggingConfig.verboseDataCalls,
+                null,
+                configuration.extendedConfig.busyStrategy,
+                busyCounters
+            )
+            val conn = NativeDatabaseConnection(this, connectionPtrArg, internalConnection = true)
+            // By the time there's a writable user connection, any rekey has already run
+            try {
+                (configuration.encryptionConfig.rekey ?: configuration.encryptionConfig.key)?.let { conn.setCipherKey(it) }
+            } catch (e: Exception) {
+                conn.close()
+                throw e
+            }
+            conn
+        }
+    }
+
+    internal fun createConnection(readOnly: Boolean = false): NativeDatabaseConnection {
+        return lock.withLock {
+            val connectionPtrArg = dbOpen(
+                path,
+                listOf(
+                    if (readOnly) OpenFlags.OPEN_READONLY else OpenFlags.CREATE_IF_NECESSARY,
+                    threadingFlag
+                ),
+                "sqliter",
+                configuration.loggingConfig.enableTrace,
+                configuration.loggingConfig.enableProfile,
+                configuration.extendedConfig.lookasideSlotSize,
+                configuration.extendedConfig.lookasideSlotCount,
+                configuration.extendedConfig.busyTimeout,
+                configuration.loggingConfig.logger,
+                configuration.loggingConfig.verboseDataCalls,
+                configuration.loggingConfig.traceListener,
+                configuration.extendedConfig.busyStrategy,
+                busyCounters
             )
             val conn = NativeDatabaseConnection(this, connectionPtrArg)
+            // Before anything else runs, so migrations, views and triggers can use them
+            configuration.extendedConfig.functions.forEach { conn.registerFunction(it) }
+            if (!readOnly)
+                conn.trackTableChanges()
             configuration.lifecycleConfig.onCreateConnection(conn)
 
             if (configuration.extendedConfig.synchronousFlag != null) {
@@ -64,6 +225,15 @@ class NativeDatabaseManager(private val path:String,
 
             if (configuration.encryptionConfig.rekey == null) {
                 configuration.encryptionConfig.key?.let { conn.setCipherKey(it) }
+            } else if (readOnly) {
+                // Read-only connections can't rewrite the file, so they only set whichever key it has now. Once a
+                // writable connection has been opened, that's the new one.
+                val currentKey = if (newConnection.value == 0) {
+                    configuration.encryptionConfig.key
+                } else {
+                    configuration.encryptionConfig.rekey
+                }
+                currentKey?.let { conn.setCipherKey(it) }
             } else {
                 if (configuration.encryptionConfig.key == null) {
                     // If executed here, it indicate that setCipherKey to `rekey` due to the old key is not set yet.
@@ -82,8 +252,21 @@ class NativeDatabaseManager(private val path:String,
             conn.updateForeignKeyConstraints(configuration.extendedConfig.foreignKeyConstraints)
             conn.updateRecursiveTriggers(configuration.extendedConfig.recursiveTriggers)
 
+            // Per-connection I/O tuning. None of these are persisted in the database file.
+            configuration.extendedConfig.let { extended ->
+                extended.mmapSize?.let { conn.updateMmapSize(it) }
+                extended.cacheSize?.let { conn.updateCacheSize(it) }
+                extended.tempStore?.let { conn.updateTempStore(it) }
+                //With background checkpoints, walAutoCheckpoint is the scheduler's threshold instead
+                if (!readOnly && checkpointScheduler == null) {
+                    extended.walAutoCheckpoint?.let { conn.updateWalAutoCheckpoint(it) }
+                }
+            }
 
-            if(newConnection.value == 0){
+            if(newConnection.value == 0 && !readOnly){
+                // Page size is fixed once the file has content, and switching to WAL writes the header, so this
+                // goes first.
+                configuration.extendedConfig.pageSize?.let { conn.updatePageSize(it) }
                 conn.updateJournalMode(configuration.journalMode)
 
                 try {
@@ -105,10 +288,12 @@ class NativeDatabaseManager(private val path:String,
                 // If this is the case, do not increment newConnection so that
                 // this if block executes on every new connection (i.e. every new
                 // ephemeral database).
-                when (path) {
-                    "", ":memory:" -> {}
-                    else -> newConnection.increment()
-                }
+                if (!isEphemeral)
+                    newConnection.increment()
+            }
+
+            if (!readOnly) {
+                checkpointScheduler?.attach(conn)
             }
 
             conn
@@ -120,6 +305,9 @@ class NativeDatabaseManager(private val path:String,
     }
 }
 
+//sqlite's default for PRAGMA wal_autocheckpoint
+private const val DEFAULT_WAL_AUTOCHECKPOINT = 1000
+
 fun AtomicInt.increment() {
     incrementAndGet()
 }
@@ -16,56 +16,170 @@
 
 package co.touchlab.sqliter.native
 
+import co.touchlab.sqliter.BatchResult
 import co.touchlab.sqliter.Cursor
 import co.touchlab.sqliter.Statement
+import co.touchlab.sqliter.StatementStats
+import co.touchlab.sqliter.withTransaction
 import co.touchlab.sqliter.interop.*
+import kotlin.system.getTimeNanos
 
 class NativeStatement internal constructor(
     internal val connection: NativeDatabaseConnection,
     internal val sqliteStatement: SqliteStatement,
-    sql: String
+    internal val sql: String
 ) : Statement {
     private val logger = connection.dbManager.configuration.loggingConfig.logger
     private val logName:String by lazy { sql.take(40) }
+
+    private val metrics = connection.dbManager.statementMetrics
+    private val histogram: LatencyHistogram? by lazy { metrics?.histogramFor(sql) }
+    private var queryStartNanos = 0L
+
+    private var columnNameMap: Map<String, Int>? = null
+    private var columnNameCount = -1
+    private var columnNameReprepares = -1
+
+    /**
+     * Column name to index, kept with the statement, so a cached statement builds it once rather than on every
+     * query. Rebuilt if a schema change has made sqlite recompile the statement, as `SELECT *` can then return
+     * different columns. Repeated names get "&JOIN1", "&JOIN2"... appended.
+     */
+    internal val columnNames: Map<String, Int>
+        get() {
+            val reprepares = sqliteStatement.reprepareCount()
+            val columnCount = sqliteStatement.columnCount()
+            columnNameMap?.let {
+                if (reprepares == columnNameReprepares && columnCount == columnNameCount)
+                    return it
+            }
+
+            val map = HashMap<String, Int>(columnCount)
+            for (i in 0 until columnCount) {
+                val key = sqliteStatement.columnName(i)
+                if (map.containsKey(key)) {
+                    var index = 1
+                    val basicKey = "$key&JOIN"
+                    var finalKey = basicKey + index
+                    while (map.containsKey(finalKey)) {
+                        finalKey = basicKey + ++index
+                    }
+                    map[finalKey] = i
+                } else {
+                    map[key] = i
+                }
+            }
+            columnNameMap = map
+            columnNameCount = columnCount
+            columnNameReprepares = reprepares
+            return map
+        }
+
     override fun execute() {
+        val start = startTiming()
         try {
             logger.v { "execute() on statement '$logName'" }
             sqliteStatement.execute()
         } finally {
+            endTiming(start)
             resetStatement()
             clearBindings()
         }
     }
 
-    override fun executeInsert(): Long = try {
-        logger.v { "executeInsert() on statement '$logName'" }
-        sqliteStatement.executeForLastInsertedRowId()
-    } finally {
-        resetStatement()
-        clearBindings()
+    override fun executeInsert(): Long {
+        val start = startTiming()
+        return try {
+            logger.v { "executeInsert() on statement '$logName'" }
+            sqliteStatement.executeForLastInsertedRowId()
+        } finally {
+            endTiming(start)
+            resetStatement()
+            clearBindings()
+        }
+    }
+
+    override fun executeUpdateDelete(): Int {
+        val start = startTiming()
+        return try {
+            logger.v { "executeUpdateDelete() on statement '$logName'" }
+            sqliteStatement.executeForChangedRowCount()
+        } finally {
+            endTiming(start)
+            resetStatement()
+            clearBindings()
+        }
     }
 
-    override fun executeUpdateDelete(): Int = try {
-        logger.v { "executeUpdateDelete() on statement '$logName'" }
-        sqliteStatement.executeForChangedRowCount()
-    } finally {
-        resetStatement()
-        clearBindings()
+    private fun startTiming(): Long = if (metrics != null) getTimeNanos() else 0L
+
+    private fun endTiming(start: Long) {
+        if (metrics != null)
+            metrics.record(sql, histogram, getTimeNanos() - start)
     }
 
+    //A cursor is timed from query() until the statement is reset or finalized
+    private fun endQueryTiming() {
+        if (queryStartNanos != 0L) {
+            endTiming(queryStartNanos)
+            queryStartNanos = 0L
+        }
+    }
+
+    override fun <T> executeBatch(rows: Iterator<T>, returning: BatchResult, bind: Statement.(T) -> Unit): LongArray {
+        logger.v { "executeBatch() on statement '$logName'" }
+        return if (connection.inTransaction) {
+            runBatch(rows, returning, bind)
+        } else {
+            connection.withTransaction { runBatch(rows, returning, bind) }
+        }
+    }
+
+    private inline fun <T> runBatch(rows: Iterator<T>, returning: BatchResult, bind: Statement.(T) -> Unit): LongArray {
+        var results = LongArray(16)
+        var count = 0
+        try {
+            while (rows.hasNext()) {
+                bind(rows.next())
+                val result = when (returning) {
+                    BatchResult.ROW_ID -> sqliteStatement.executeForLastInsertedRowId()
+                    BatchResult.CHANGED_ROWS -> sqliteStatement.executeForChangedRowCount().toLong()
+                }
+                sqliteStatement.resetStatement()
+                sqliteStatement.clearBindings()
+                if (count == results.size)
+                    results = results.copyOf(count * 2)
+                results[count++] = result
+            }
+        } finally {
+            resetStatement()
+            clearBindings()
+        }
+        return results.copyOf(count)
+    }
+
+    override fun stats(reset: Boolean): StatementStats = sqliteStatement.stats(reset)
+
     override fun query(): Cursor {
         logger.v { "query() on statement '$logName'" }
+        if (metrics != null)
+            queryStartNanos = getTimeNanos()
         return NativeCursor(this)
     }
 
     override fun finalizeStatement() {
         logger.v { "finalizeStatement() on statement '$logName'" }
-        sqliteStatement.finalizeStatement()
+        endQueryTiming()
+        connection.rollUpStats(this)
+        if (!connection.recycleStatement(this))
+            sqliteStatement.finalizeStatement()
     }
 
     override fun resetStatement() {
         logger.v { "resetStatement() on statement '$logName'" }
+        endQueryTiming()
         sqliteStatement.resetStatement()
+        connection.publishTableChanges()
     }
 
     override fun clearBindings() {
@@ -92,6 +206,10 @@ class NativeStatement internal constructor(
         sqliteStatement.bindBlob(index, value)
     }
 
+    override fun bindZeroBlob(index: Int, size: Int) {
+        sqliteStatement.bindZeroBlob(index, size)
+    }
+
     override fun bindParameterIndex(paramName: String): Int {
         val index = sqliteStatement.bindParameterIndex(paramName)
         if (index == 0)
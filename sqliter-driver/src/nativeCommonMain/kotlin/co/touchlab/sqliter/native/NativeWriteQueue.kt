@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.DatabaseConnection
+import co.touchlab.sqliter.PendingWrite
+import co.touchlab.sqliter.WriteQueue
+import co.touchlab.sqliter.concurrency.Condition
+import co.touchlab.sqliter.concurrency.withLock
+import co.touchlab.sqliter.withTransaction
+import kotlin.native.concurrent.Worker
+import kotlin.system.getTimeNanos
+
+internal class NativeWriteQueue(
+    manager: NativeDatabaseManager,
+    private val maxBatch: Int,
+    maxDelayMillis: Long
+) : WriteQueue {
+    private val maxDelayNanos = maxDelayMillis * 1_000_000
+
+    //Opened here rather than on the writer thread, so migration failures are thrown to the caller
+    private val connection = manager.createConnection()
+
+    //Each write runs inside its own savepoint, so these are prepared once for the writer connection
+    private val savepoint = connection.prepareControlStatement("SAVEPOINT sqliter_write;")
+    private val rollbackToSavepoint = connection.prepareControlStatement("ROLLBACK TO sqliter_write;")
+    private val releaseSavepoint = connection.prepareControlStatement("RELEASE sqliter_write;")
+
+    //Guards the queue and the completion state of every write. Signalled when either changes.
+    private val condition = Condition()
+    private val queue = ArrayDeque<QueuedWrite<*>>()
+    private var closing = false
+
+    private val worker = Worker.start(name = "sqliter-write-queue")
+
+    init {
+        worker.executeAfter(0L) { runWriter() }
+    }
+
+    override fun <R> submit(block: (DatabaseConnection) -> R): PendingWrite<R> {
+        val write = QueuedWrite(block)
+        condition.withLock {
+            check(!closing) { "Write queue is closed" }
+            queue.addLast(write)
+            condition.signalAll()
+        }
+        return write
+    }
+
+    override fun close() {
+        condition.withLock {
+            if (closing)
+                return
+            closing = true
+            condition.signalAll()
+        }
+
+        worker.requestTermination().result
+        savepoint.finalizeStatement()
+        rollbackToSavepoint.finalizeStatement()
+        releaseSavepoint.finalizeStatement()
+        connection.close()
+    }
+
+    private fun runWriter() {
+        while (true) {
+            val batch = nextBatch() ?: return
+            commit(batch)
+
+            condition.withLock {
+                batch.forEach { it.finished = true }
+                condition.signalAll()
+            }
+        }
+    }
+
+    /**
+     * Waits for at least one write, then for up to maxDelayNanos while the batch is under maxBatch. Returns null
+     * when the queue is closed and drained.
+     */
+    private fun nextBatch(): List<QueuedWrite<*>>? = condition.withLock {
+        while (queue.isEmpty() && !closing) {
+            condition.await()
+        }
+        if (queue.isEmpty())
+            return null
+
+        if (maxDelayNanos > 0) {
+            val deadline = getTimeNanos() + maxDelayNanos
+            var remaining = maxDelayNanos
+            while (queue.size < maxBatch && !closing && remaining > 0) {
+                condition.await(remaining)
+                remaining = deadline - getTimeNanos()
+            }
+        }
+
+        val batch = ArrayList<QueuedWrite<*>>(minOf(queue.size, maxBatch))
+        while (batch.size < maxBatch && queue.isNotEmpty()) {
+            batch.add(queue.removeFirst())
+        }
+        batch
+    }
+
+    private fun commit(batch: List<QueuedWrite<*>>) {
+        try {
+            connection.withTransaction { conn ->
+                batch.forEach { write ->
+                    connection.executeControlStatement(savepoint)
+                    try {
+                        write.run(conn)
+                    } catch (e: Throwable) {
+                        write.error = e
+                        connection.executeControlStatement(rollbackToSavepoint)
+                    }
+                    connection.executeControlStatement(releaseSavepoint)
+                }
+            }
+        } catch (e: Throwable) {
+            //Nothing in the batch was committed, including writes that succeeded
+            batch.forEach { write ->
+                if (write.error == null)
+                    write.error = e
+            }
+        }
+    }
+
+    private inner class QueuedWrite<R>(private val block: (DatabaseConnection) -> R) : PendingWrite<R> {
+        //Set on the writer thread, and published to other threads by setting finished under the condition lock
+        private var result: R? = null
+        var error: Throwable? = null
+        var finished = false
+
+        fun run(conn: DatabaseConnection) {
+            result = block(conn)
+        }
+
+        override val isDone: Boolean
+            get() = condition.withLock { finished }
+
+        override fun await(): R {
+            condition.withLock {
+                while (!finished) {
+                    condition.await()
+                }
+            }
+
+            error?.let { throw it }
+            @Suppress("UNCHECKED_CAST")
+            return result as R
+        }
+    }
+}
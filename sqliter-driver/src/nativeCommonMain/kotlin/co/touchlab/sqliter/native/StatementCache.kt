@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.StatementCacheStats
+
+/**
+ * LRU cache of idle prepared statements, keyed by SQL text. Statements are removed from the cache while
+ * they're in use, and put back by NativeStatement.finalizeStatement. Access is serialized by the owning
+ * connection, so there is no locking here.
+ */
+internal class StatementCache(val maxSize: Int) {
+    //Insertion order is recency order, as entries are removed on take and re-inserted on put
+    private val idle = LinkedHashMap<String, NativeStatement>()
+
+    private var hits = 0L
+    private var misses = 0L
+    private var evictions = 0L
+
+    val enabled: Boolean
+        get() = maxSize > 0
+
+    fun take(sql: String): NativeStatement? {
+        val statement = idle.remove(sql)
+        if (statement == null) {
+            misses++
+        } else {
+            hits++
+        }
+        return statement
+    }
+
+    /**
+     * Returns false if the statement can't be cached, in which case the caller should finalize it.
+     */
+    fun put(statement: NativeStatement): Boolean {
+        if (!enabled)
+            return false
+
+        val displaced = idle.remove(statement.sql)
+        idle[statement.sql] = statement
+        if (displaced != null && displaced !== statement) {
+            displaced.sqliteStatement.finalizeStatement()
+        }
+
+        while (idle.size > maxSize) {
+            val eldest = idle.keys.first()
+            idle.remove(eldest)?.sqliteStatement?.finalizeStatement()
+            evictions++
+        }
+
+        return true
+    }
+
+    fun clear() {
+        idle.values.forEach { it.sqliteStatement.finalizeStatement() }
+        idle.clear()
+    }
+
+    fun stats(): StatementCacheStats = StatementCacheStats(
+        hits = hits,
+        misses = misses,
+        evictions = evictions,
+        size = idle.size,
+        maxSize = maxSize
+    )
+}
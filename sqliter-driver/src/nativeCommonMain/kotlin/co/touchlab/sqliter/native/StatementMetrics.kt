@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.StatementLatency
+import co.touchlab.sqliter.interop.Logger
+import kotlin.concurrent.AtomicLong
+import kotlin.concurrent.AtomicReference
+
+/**
+ * Statement timing shared by all connections from one manager. Statements look up their histogram once, so
+ * recording is a few atomic increments, and never takes a lock.
+ */
+internal class StatementMetrics(
+    private val logger: Logger,
+    private val collectHistograms: Boolean,
+    private val slowThresholdNanos: Long,
+    private val maxFingerprints: Int = 500
+) {
+    private val histograms = AtomicReference<Map<String, LatencyHistogram>>(emptyMap())
+
+    /**
+     * Histogram for [sql], or null if histograms are off. Once [maxFingerprints] is reached, new SQL goes to a
+     * shared overflow entry.
+     */
+    fun histogramFor(sql: String): LatencyHistogram? {
+        if (!collectHistograms)
+            return null
+
+        val fingerprint = fingerprint(sql)
+        while (true) {
+            val current = histograms.value
+            current[fingerprint]?.let { return it }
+            val key = if (current.size >= maxFingerprints) OVERFLOW_KEY else fingerprint
+            current[key]?.let { return it }
+
+            val histogram = LatencyHistogram()
+            if (histograms.compareAndSet(current, current + (key to histogram)))
+                return histogram
+        }
+    }
+
+    fun record(sql: String, histogram: LatencyHistogram?, nanos: Long) {
+        histogram?.record(nanos)
+        if (slowThresholdNanos in 0..nanos) {
+            logger.trace("Slow statement took ${nanos / 1_000_000}ms: $sql")
+        }
+    }
+
+    fun snapshot(): List<StatementLatency> = histograms.value.map { (sql, histogram) -> histogram.snapshot(sql) }
+
+    fun reset() {
+        histograms.value.values.forEach { it.reset() }
+    }
+
+    companion object {
+        const val OVERFLOW_KEY = "<other>"
+
+        /**
+         * Key for [sql] with whitespace runs collapsed and string, blob and numeric literals replaced by `?`, so
+         * statements that inline their values share a histogram with the bound form. Quoted identifiers are kept.
+         */
+        fun fingerprint(sql: String): String {
+            val out = StringBuilder(sql.length)
+            var i = 0
+            while (i < sql.length) {
+                val c = sql[i]
+                //Numbered parameters like ?1 keep their digits
+                val startsToken = out.isEmpty() || !(out.last().isIdentifierPart() || out.last() == '?')
+                when {
+                    c.isWhitespace() -> {
+                        while (i < sql.length && sql[i].isWhitespace()) i++
+                        if (out.isNotEmpty() && i < sql.length) out.append(' ')
+                        continue
+                    }
+                    c == '\'' || (startsToken && (c == 'x' || c == 'X') && sql.getOrNull(i + 1) == '\'') -> {
+                        i = skipQuoted(sql, if (c == '\'') i else i + 1, '\'')
+                        out.append('?')
+                        continue
+                    }
+                    c == '"' || c == '`' || c == '[' -> {
+                        val end = skipQuoted(sql, i, if (c == '[') ']' else c)
+                        out.appendRange(sql, i, end)
+                        i = end
+                        continue
+                    }
+                    startsToken && (c.isDigit() || (c == '.' && sql.getOrNull(i + 1)?.isDigit() == true)) -> {
+                        val hex = sql.startsWith("0x", i, ignoreCase = true)
+                        i++
+                        while (i < sql.length) {
+                            val n = sql[i]
+                            val exponentSign = !hex && (n == '+' || n == '-') && (sql[i - 1] == 'e' || sql[i - 1] == 'E')
+                            if (!n.isIdentifierPart() && n != '.' && !exponentSign) break
+                            i++
+                        }
+                        out.append('?')
+                        continue
+                    }
+                    else -> out.append(c)
+                }
+                i++
+            }
+            return out.toString()
+        }
+
+        private fun Char.isIdentifierPart() = isLetterOrDigit() || this == '_' || this == '$'
+
+        /**
+         * Index just past the quoted run starting at [start], where a doubled [close] is an escaped quote.
+         */
+        private fun skipQuoted(sql: String, start: Int, close: Char): Int {
+            var i = start + 1
+            while (i < sql.length) {
+                if (sql[i] == close) {
+                    if (close != ']' && sql.getOrNull(i + 1) == close) {
+                        i += 2
+                        continue
+                    }
+                    return i + 1
+                }
+                i++
+            }
+            return sql.length
+        }
+    }
+}
+
+/**
+ * Log-linear histogram. Each power of two range is split into 4 buckets.
+ */
+internal class LatencyHistogram {
+    private val buckets = Array(BUCKET_COUNT) { AtomicLong(0) }
+    private val count = AtomicLong(0)
+    private val total = AtomicLong(0)
+    private val max = AtomicLong(0)
+
+    fun record(nanos: Long) {
+        val value = if (nanos < 0) 0 else nanos
+        buckets[bucketFor(value)].incrementAndGet()
+        count.incrementAndGet()
+        total.addAndGet(value)
+        while (true) {
+            val currentMax = max.value
+            if (value <= currentMax || max.compareAndSet(currentMax, value))
+                break
+        }
+    }
+
+    fun reset() {
+        buckets.forEach { it.value = 0 }
+        count.value = 0
+        total.value = 0
+        max.value = 0
+    }
+
+    fun snapshot(sql: String): StatementLatency {
+        val counts = LongArray(BUCKET_COUNT) { buckets[it].value }
+        val maxValue = max.value
+        return StatementLatency(
+            sql = sql,
+            count = count.value,
+            totalNanos = total.value,
+            p50Nanos = percentile(counts, 0.50, maxValue),
+            p95Nanos = percentile(counts, 0.95, maxValue),
+            p99Nanos = percentile(counts, 0.99, maxValue),
+            maxNanos = maxValue
+        )
+    }
+
+    private fun percentile(counts: LongArray, fraction: Double, maxValue: Long): Long {
+        val sampleCount = counts.sum()
+        if (sampleCount == 0L)
+            return 0
+
+        val rank = kotlin.math.ceil(sampleCount * fraction).toLong().coerceAtLeast(1)
+        var seen = 0L
+        for (i in counts.indices) {
+            seen += counts[i]
+            if (seen >= rank)
+                return minOf(bucketUpperBound(i), maxValue)
+        }
+        return maxValue
+    }
+
+    companion object {
+        const val BUCKET_COUNT = 248
+
+        fun bucketFor(nanos: Long): Int {
+            if (nanos < 4)
+                return nanos.toInt()
+            val msb = 63 - nanos.countLeadingZeroBits()
+            val sub = ((nanos ushr (msb - 2)) and 3).toInt()
+            return (msb - 1) * 4 + sub
+        }
+
+        fun bucketUpperBound(index: Int): Long {
+            if (index < 4)
+                return index.toLong()
+            val msb = index / 4 + 1
+            val sub = index % 4
+            val width = 1L shl (msb - 2)
+            return ((4L + sub) shl (msb - 2)) + width - 1
+        }
+    }
+}
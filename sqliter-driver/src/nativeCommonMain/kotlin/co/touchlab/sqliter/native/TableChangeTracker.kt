@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.native
+
+import co.touchlab.sqliter.interop.ChangeHookListener
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.toKString
+
+/**
+ * Collects the tables changed on one connection from sqlite's update hook. They're held per transaction, moved aside
+ * when it starts to commit, and dropped if it rolls back. Only accessed by the thread using the connection.
+ *
+ * Changes rolled back to a savepoint stay in the set, so a transaction can report a table that ended up unchanged,
+ * but never misses one it did change.
+ */
+internal class TableChangeTracker(private val manager: NativeDatabaseManager) : ChangeHookListener {
+    private val pending = HashSet<String>()
+    private val committed = HashSet<String>()
+
+    //Statements report the same table pointer for every row, so this skips the string conversion after the first
+    private var lastTable: CPointer<ByteVar>? = null
+
+    val hasCommitted: Boolean
+        get() = committed.isNotEmpty()
+
+    override fun onChange(database: CPointer<ByteVar>?, table: CPointer<ByteVar>?) {
+        if (table == null || table == lastTable || !manager.hasTableChangeListeners)
+            return
+        lastTable = table
+
+        val name = table.toKString()
+        when (val schema = database?.toKString()) {
+            "temp" -> {}
+            null, "main" -> pending.add(name)
+            else -> pending.add("$schema.$name")
+        }
+    }
+
+    override fun onCommit() {
+        committed.addAll(pending)
+        pending.clear()
+        lastTable = null
+    }
+
+    override fun onRollback() {
+        pending.clear()
+        committed.clear()
+        lastTable = null
+    }
+
+    fun takeCommitted(): Set<String> {
+        val tables = committed.toSet()
+        committed.clear()
+        return tables
+    }
+}
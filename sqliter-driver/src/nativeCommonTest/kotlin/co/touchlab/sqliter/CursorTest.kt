@@ -16,10 +16,207 @@
 
 package co.touchlab.sqliter
 
+import kotlinx.cinterop.readBytes
 import kotlin.test.Test
+import kotlin.test.assertContentEquals
 import kotlin.test.assertEquals
+import kotlin.test.assertFails
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
 
 class CursorTest:BaseDatabaseTest(){
+    @Test
+    fun fetchColumnsInChunks(){
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+            create = { db ->
+                db.withStatement("CREATE TABLE test (num INTEGER, val REAL, str TEXT, data BLOB)") {
+                    execute()
+                }
+            }))
+
+        val connection = manager.surpriseMeConnection()
+        connection.withStatement("insert into test(num, val, str, data)values(?,?,?,?)"){
+            executeBatch(0 until 150) { i ->
+                bindLong(1, i.toLong())
+                bindDouble(2, if (i % 3 == 0) null else i * 1.5)
+                bindString(3, "row $i")
+                bindBlob(4, byteArrayOf(i.toByte()))
+            }
+        }
+
+        connection.withStatement("select num, val, str, data from test order by num"){
+            val cursor = query()
+            val chunk = ColumnChunk(
+                arrayOf(FieldType.TYPE_INTEGER, FieldType.TYPE_FLOAT, FieldType.TYPE_TEXT, FieldType.TYPE_BLOB),
+                100
+            )
+
+            assertEquals(100, cursor.fetchColumns(chunk))
+            assertEquals(99L, chunk.longs(0)[99])
+            assertTrue(chunk.isNull(1, 0))
+            assertFalse(chunk.isNull(1, 1))
+            assertEquals(1.5, chunk.doubles(1)[1])
+            assertTrue(chunk.isNull(1, 99))
+            assertEquals("row 64", chunk.strings(2)[64])
+            assertContentEquals(byteArrayOf(70), chunk.blobs(3)[70])
+
+            assertEquals(50, cursor.fetchColumns(chunk))
+            assertEquals(149L, chunk.longs(0)[49])
+            assertFalse(chunk.isNull(1, 1))
+
+            assertEquals(0, cursor.fetchColumns(chunk))
+        }
+
+        connection.withStatement("select num from test where num < 5 order by num"){
+            val chunk = query().fetchColumns(10, FieldType.TYPE_INTEGER)
+            assertEquals(5, chunk.rowCount)
+            assertContentEquals(longArrayOf(0, 1, 2, 3, 4), chunk.longs(0).copyOf(chunk.rowCount))
+        }
+        connection.close()
+    }
+
+    @Test
+    fun zeroCopyBlobAndText(){
+        basicTestDb(TWO_COL) { manager ->
+            val connection = manager.surpriseMeConnection()
+            connection.withStatement("insert into test(num, str)values(?,?)"){
+                bindLong(1, 1)
+                bindString(2, "héllo")
+                executeInsert()
+            }
+            connection.withStatement("select cast(str as blob), str, null from test"){
+                val cursor = query()
+                assertTrue(cursor.next())
+                val expected = "héllo".encodeToByteArray()
+
+                assertEquals(expected.size, cursor.withBlob(0) { bytes, size ->
+                    assertNotNull(bytes)
+                    assertContentEquals(expected, bytes!!.readBytes(size))
+                    size
+                })
+                cursor.withText(1) { utf8, size ->
+                    assertEquals("héllo", utf8!!.readBytes(size).decodeToString())
+                }
+                cursor.withBlob(2) { bytes, size ->
+                    assertNull(bytes)
+                    assertEquals(0, size)
+                }
+
+                val dest = ByteArray(expected.size + 2)
+                assertEquals(expected.size, cursor.getBytesInto(0, dest, 2))
+                assertContentEquals(expected, dest.copyOfRange(2, dest.size))
+
+                val small = ByteArray(3)
+                assertEquals(expected.size, cursor.getBytesInto(0, small))
+                assertContentEquals(expected.copyOf(3), small)
+
+                assertEquals(expected.size, cursor.getBytesInto(0, small, small.size))
+                assertFailsWith<IndexOutOfBoundsException> { cursor.getBytesInto(0, small, -1) }
+                assertFailsWith<IndexOutOfBoundsException> { cursor.getBytesInto(0, small, small.size + 1) }
+            }
+            connection.close()
+        }
+    }
+
+    @Test
+    fun mapRowsByIndex(){
+        basicTestDb(TWO_COL) { manager ->
+            val connection = manager.surpriseMeConnection()
+            connection.withStatement("insert into test(num, str)values(?,?)"){
+                executeBatch(3) { i ->
+                    bindLong(1, i.toLong())
+                    bindString(2, "row $i")
+                }
+            }
+            connection.withStatement("select num, str from test order by num"){
+                val first = query()
+                val rows = first.mapRows("str", "num") { c, col -> c.getString(col[0]) to c.getLong(col[1]) }
+                assertEquals(listOf("row 0" to 0L, "row 1" to 1L, "row 2" to 2L), rows)
+                val names = first.columnNames
+                resetStatement()
+
+                //Column names are kept with the statement between queries
+                val second = query()
+                assertSame(names, second.columnNames)
+                val sequence = second.rowSequence { c, _ -> c.getLong(0) }
+                assertEquals(listOf(0L, 1L), sequence.take(2).toList())
+                assertFails { sequence.toList() }
+                resetStatement()
+
+                assertFails { query().mapRows("missing") { c, _ -> c.getLong(0) } }
+            }
+            connection.close()
+        }
+    }
+
+    @Test
+    fun cachedStatementColumnsFollowSchemaChange(){
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+            extendedConfig = DatabaseConfiguration.Extended(statementCacheSize = 4),
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            }
+        ))
+        manager.withConnection { conn ->
+            conn.rawExecSql("insert into test(num, str)values(1, 'a')")
+            val before = conn.withStatement("select * from test") {
+                query().mapRows("num", "str") { c, col -> c.getLong(col[0]) to c.getString(col[1]) }
+            }
+            assertEquals(listOf(1L to "a"), before)
+
+            conn.rawExecSql("alter table test add column extra TEXT")
+            conn.rawExecSql("update test set extra = 'x'")
+
+            //Same cached statement, recompiled by sqlite with the new column
+            conn.withStatement("select * from test") {
+                val cursor = query()
+                assertEquals(listOf("x" to 1L), cursor.mapRows("extra", "num") { c, col -> c.getString(col[0]) to c.getLong(col[1]) })
+                assertEquals(3, cursor.columnNames.size)
+            }
+            assertTrue(conn.statementCacheStats().hits > 0)
+        }
+    }
+
+    @Test
+    fun bulkColumnTypes(){
+        for (type in FieldType.values()) {
+            assertEquals(type, FieldType.forCode(type.nativeCode))
+        }
+        assertFails { FieldType.forCode(0) }
+        assertFails { FieldType.forCode(6) }
+
+        basicTestDb(TWO_COL) { manager ->
+            val connection = manager.surpriseMeConnection()
+            connection.withStatement("select 1, 1.5, 'a', x'01', null"){
+                val cursor = query()
+                assertTrue(cursor.next())
+                val types = IntArray(5)
+                assertEquals(5, cursor.getTypes(types))
+                assertEquals(
+                    listOf(FieldType.TYPE_INTEGER, FieldType.TYPE_FLOAT, FieldType.TYPE_TEXT, FieldType.TYPE_BLOB, FieldType.TYPE_NULL),
+                    types.map { FieldType.forCode(it) }
+                )
+
+                val firstTwo = IntArray(2)
+                assertEquals(2, cursor.getTypes(firstTwo))
+                assertEquals(FieldType.TYPE_FLOAT.nativeCode, firstTwo[1])
+            }
+            connection.close()
+        }
+    }
+
     @Test
     fun iterator(){
         val manager = createDatabaseManager(DatabaseConfiguration(
@@ -63,6 +260,57 @@ class CursorTest:BaseDatabaseTest(){
         connection.close()
     }
 
+    /**
+     * Implements only the members Cursor had originally, like a Cursor written against an older release.
+     */
+    private class BaselineCursor(private val cursor: Cursor) : Cursor {
+        override fun next(): Boolean = cursor.next()
+        override fun isNull(index: Int): Boolean = cursor.isNull(index)
+        override fun getString(index: Int): String = cursor.getString(index)
+        override fun getLong(index: Int): Long = cursor.getLong(index)
+        override fun getBytes(index: Int): ByteArray = cursor.getBytes(index)
+        override fun getDouble(index: Int): Double = cursor.getDouble(index)
+        override fun getType(index: Int): FieldType = cursor.getType(index)
+        override val columnCount: Int get() = cursor.columnCount
+        override fun columnName(index: Int): String = cursor.columnName(index)
+        override val columnNames: Map<String, Int> get() = cursor.columnNames
+        override val statement: Statement get() = cursor.statement
+    }
+
+    @Test
+    fun defaultMembersUseBaselineCursor(){
+        basicTestDb(TWO_COL) { manager ->
+            val connection = manager.surpriseMeConnection()
+            connection.withStatement("insert into test(num, str)values(?,?)"){
+                executeBatch(3) { i ->
+                    bindLong(1, i.toLong())
+                    bindString(2, "row $i")
+                }
+            }
+            connection.withStatement("select num, str, cast(str as blob) from test order by num"){
+                val cursor = BaselineCursor(query())
+                assertTrue(cursor.next())
+
+                val types = IntArray(3)
+                assertEquals(3, cursor.getTypes(types))
+                assertEquals(FieldType.TYPE_INTEGER, FieldType.forCode(types[0]))
+                assertEquals("row 0", cursor.withText(1) { utf8, size -> utf8!!.readBytes(size).decodeToString() })
+                assertContentEquals("row 0".encodeToByteArray(), cursor.withBlob(2) { bytes, size -> bytes!!.readBytes(size) })
+
+                val dest = ByteArray(3)
+                assertEquals(5, cursor.getBytesInto(2, dest, 1))
+                assertContentEquals(byteArrayOf(0, 'r'.code.toByte(), 'o'.code.toByte()), dest)
+                assertFailsWith<IndexOutOfBoundsException> { cursor.getBytesInto(2, dest, 4) }
+
+                val chunk = ColumnChunk(arrayOf(FieldType.TYPE_INTEGER, FieldType.TYPE_TEXT), 10)
+                assertEquals(2, cursor.fetchColumns(chunk))
+                assertContentEquals(longArrayOf(1, 2), chunk.longs(0).copyOf(2))
+                assertEquals("row 2", chunk.strings(1)[1])
+            }
+            connection.close()
+        }
+    }
+
     @Test
     fun testUtf8() {
         fun runStringTest(connection: DatabaseConnection, id: Long, str:String) {
@@ -16,10 +16,258 @@
 
 package co.touchlab.sqliter
 
+import co.touchlab.sqliter.interop.Logger
+import co.touchlab.sqliter.interop.SqlTraceListener
+import platform.posix.usleep
+import kotlin.concurrent.AtomicInt
 import kotlin.test.*
 
 class DatabaseConfigurationTest : BaseDatabaseTest(){
 
+    @Test
+    fun busyStrategyDelays(){
+        assertEquals(-1, BusyStrategy.SqliteBusyHandler.nextDelayMicros(0, 0))
+
+        val fixed = BusyStrategy.FixedDelay(maxRetries = 2, delayMicros = 100)
+        assertEquals(100, fixed.nextDelayMicros(0, 0))
+        assertEquals(100, fixed.nextDelayMicros(1, 0))
+        assertEquals(-1, fixed.nextDelayMicros(2, 0))
+
+        val backoff = BusyStrategy.ExponentialBackoff(
+            initialDelayMicros = 100,
+            maxDelayMicros = 1000,
+            timeoutMillis = 10,
+            jitter = false
+        )
+        assertEquals(100, backoff.nextDelayMicros(0, 0))
+        assertEquals(400, backoff.nextDelayMicros(2, 0))
+        assertEquals(1000, backoff.nextDelayMicros(20, 0))
+        assertEquals(500, backoff.nextDelayMicros(20, 9_500_000))
+        assertEquals(-1, backoff.nextDelayMicros(20, 10_000_000))
+
+        val jittered = backoff.copy(jitter = true)
+        for (i in 0 until 100) {
+            val delay = jittered.nextDelayMicros(3, 0)
+            assertTrue(delay in 400..800, "delay $delay")
+        }
+
+        //A large initial delay mustn't overflow when shifted
+        val large = BusyStrategy.ExponentialBackoff(
+            initialDelayMicros = 900_000,
+            maxDelayMicros = 999_999,
+            timeoutMillis = Long.MAX_VALUE / 1000,
+            jitter = false
+        )
+        assertEquals(999_999, large.nextDelayMicros(40, 0))
+        assertEquals(999_999, large.nextDelayMicros(Int.MAX_VALUE, 0))
+
+        assertFails { BusyStrategy.ExponentialBackoff(maxDelayMicros = 1_000_000) }
+        assertFails { BusyStrategy.FixedDelay(delayMicros = 1_000_000) }
+        assertFails { BusyStrategy.FixedDelay(maxRetries = -1) }
+    }
+
+    @Test
+    fun traceAndProfileListener(){
+        val statements = mutableListOf<String>()
+        val profiles = mutableListOf<Pair<String, Long>>()
+        val listener = object : SqlTraceListener {
+            override fun onStatement(sql: String) {
+                statements.add(sql)
+            }
+
+            override fun onProfile(sql: String, elapsedNanos: Long) {
+                profiles.add(Pair(sql, elapsedNanos))
+            }
+        }
+
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            loggingConfig = DatabaseConfiguration.Logging(
+                logger = NoneLogger,
+                enableTrace = true,
+                enableProfile = true,
+                traceListener = listener
+            )
+        ))
+
+        val conn = manager.createMultiThreadedConnection()
+        try {
+            statements.clear()
+            profiles.clear()
+            conn.withStatement("insert into test(num, str)values(?,?)") {
+                bindLong(1, 1)
+                bindString(2, "a")
+                executeInsert()
+            }
+
+            assertEquals(listOf("insert into test(num, str)values(?,?)"), statements)
+            assertEquals(1, profiles.size)
+            assertEquals("insert into test(num, str)values(?,?)", profiles[0].first)
+            assertTrue(profiles[0].second >= 0)
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun callbackExceptionsGoToLogger(){
+        val errors = mutableListOf<Throwable?>()
+        val logger = object : Logger {
+            override fun trace(message: String) = Unit
+            override val vActive: Boolean = false
+            override fun vWrite(message: String) = Unit
+            override val eActive: Boolean = true
+            override fun eWrite(message: String, exception: Throwable?) {
+                errors.add(exception)
+            }
+        }
+        val listener = object : SqlTraceListener {
+            override fun onStatement(sql: String) {
+                throw IllegalStateException("listener failed")
+            }
+
+            override fun onProfile(sql: String, elapsedNanos: Long) = Unit
+        }
+
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            loggingConfig = DatabaseConfiguration.Logging(logger = logger, enableTrace = true, traceListener = listener)
+        ))
+
+        val conn = manager.createMultiThreadedConnection()
+        try {
+            errors.clear()
+            conn.rawExecSql("insert into test(num, str)values(1, 'a')")
+            assertEquals(1, conn.longForQuery("select count(*) from test"))
+            assertTrue(errors.isNotEmpty())
+            assertEquals("listener failed", errors[0]?.message)
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun ioTuningSettings(){
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            extendedConfig = DatabaseConfiguration.Extended(
+                pageSize = 8192,
+                mmapSize = 1L shl 20,
+                cacheSize = -4000,
+                tempStore = TempStore.MEMORY,
+                walAutoCheckpoint = 500
+            ),
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger)
+        ))
+
+        val conn = manager.createMultiThreadedConnection()
+        try {
+            assertEquals(8192, conn.longForQuery("PRAGMA page_size"))
+            assertEquals(-4000, conn.longForQuery("PRAGMA cache_size"))
+            assertEquals(TempStore.MEMORY.value.toLong(), conn.longForQuery("PRAGMA temp_store"))
+            assertEquals(500, conn.longForQuery("PRAGMA wal_autocheckpoint"))
+            //0 if sqlite was built without mmap support
+            assertTrue(conn.longForQuery("PRAGMA mmap_size") in listOf(0L, 1L shl 20))
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun backgroundCheckpoint(){
+        val opened = AtomicInt(0)
+        val closed = AtomicInt(0)
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            extendedConfig = DatabaseConfiguration.Extended(walAutoCheckpoint = 10, backgroundCheckpoint = true),
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+            lifecycleConfig = DatabaseConfiguration.Lifecycle(
+                onCreateConnection = { opened.incrementAndGet() },
+                onCloseConnection = { closed.incrementAndGet() }
+            )
+        ))
+
+        val conn = manager.createMultiThreadedConnection()
+        try {
+            val text = "x".repeat(1000)
+            for (i in 0 until 20) {
+                conn.withStatement("insert into test(num, str)values(?,?)") {
+                    executeBatch(50) { row ->
+                        bindLong(1, row.toLong())
+                        bindString(2, text)
+                    }
+                }
+            }
+
+            var waited = 0
+            while (manager.checkpointStats().checkpoints == 0L && waited < 5000) {
+                usleep(10_000u)
+                waited += 10
+            }
+
+            val stats = manager.checkpointStats()
+            assertTrue(stats.checkpoints > 0)
+            assertEquals(0, stats.failures)
+            assertTrue(stats.maxWalPages >= 10)
+            assertEquals(1000, conn.longForQuery("select count(*) from test"))
+        } finally {
+            conn.close()
+        }
+
+        //The scheduler's own connection isn't a user connection
+        assertEquals(1, opened.value)
+        assertEquals(1, closed.value)
+
+        assertFails {
+            DatabaseConfiguration(
+                name = TEST_DB_NAME,
+                version = 1,
+                create = {},
+                extendedConfig = DatabaseConfiguration.Extended(walAutoCheckpoint = 0, backgroundCheckpoint = true)
+            )
+        }
+    }
+
+    @Test
+    fun ioTuningValidation(){
+        fun config(extended: DatabaseConfiguration.Extended) = DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = {},
+            extendedConfig = extended
+        )
+
+        assertFails { config(DatabaseConfiguration.Extended(pageSize = 1000)) }
+        assertFails { config(DatabaseConfiguration.Extended(pageSize = 256)) }
+        assertFails { config(DatabaseConfiguration.Extended(mmapSize = -1)) }
+        assertFails { config(DatabaseConfiguration.Extended(walAutoCheckpoint = -1)) }
+        config(DatabaseConfiguration.Extended(pageSize = 65536, cacheSize = -2000, walAutoCheckpoint = 0))
+    }
+
     @Test
     fun pathTest(){
         val dbPathString = DatabaseFileContext.databasePath(TEST_DB_NAME, null)
@@ -18,11 +18,96 @@ package co.touchlab.sqliter
 
 import co.touchlab.sqliter.DatabaseFileContext.deleteDatabase
 import co.touchlab.sqliter.concurrency.ConcurrentDatabaseConnection
+import co.touchlab.sqliter.interop.SQLiteInterruptedException
+import platform.posix.usleep
 import kotlin.test.*
 
 class DatabaseConnectionTest {
     @Test
-    fun secondTransactionFailsRetainsExistingTransaction() {
+    fun deadlineAbortsRunawayQuery() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                val e = assertFailsWith<SQLiteInterruptedException> {
+                    conn.withDeadline(50) { c -> c.longForQuery(ENDLESS_QUERY) }
+                }
+                assertTrue(e.deadlineExceeded)
+
+                //Deadline is gone once the block returns
+                assertEquals(0, conn.longForQuery("select count(*) from test"))
+
+                //Nested deadlines can't outlast the outer one
+                assertFailsWith<SQLiteInterruptedException> {
+                    conn.withDeadline(50) { c -> c.withDeadline(60_000) { c.longForQuery(ENDLESS_QUERY) } }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun deadlineInsideTransactionKeepsInterruptedError() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                val e = assertFailsWith<SQLiteInterruptedException> {
+                    conn.withDeadline(50) { c ->
+                        c.withTransaction { t ->
+                            t.rawExecSql("insert into test(num, str)values(1, 'kept?')")
+                            t.withTransaction { nested ->
+                                nested.rawExecSql(ENDLESS_INSERT)
+                            }
+                        }
+                    }
+                }
+                assertTrue(e.deadlineExceeded)
+
+                //sqlite rolled back the whole transaction, and the connection is usable again
+                assertEquals(0, conn.longForQuery("select count(*) from test"))
+                conn.withTransaction { t -> t.rawExecSql("insert into test(num, str)values(2, 'after')") }
+                assertEquals(1, conn.longForQuery("select count(*) from test"))
+            }
+        }
+    }
+
+    @Test
+    fun interruptedTransactionCantBeCommitted() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                conn.beginTransaction()
+                assertFailsWith<SQLiteInterruptedException> {
+                    conn.withDeadline(50) { c -> c.rawExecSql(ENDLESS_INSERT) }
+                }
+                conn.setTransactionSuccessful()
+                assertFailsWith<IllegalStateException> { conn.endTransaction() }
+                assertEquals(0, conn.longForQuery("select count(*) from test"))
+            }
+        }
+    }
+
+    @Test
+    fun interruptFromAnotherThread() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                val worker = createWorker()
+                try {
+                    val future = worker.runBackground {
+                        usleep(100_000u)
+                        conn.interrupt()
+                    }
+                    //The deadline is only a safety net, in case the interrupt misses
+                    val e = assertFailsWith<SQLiteInterruptedException> {
+                        conn.withDeadline(30_000) { c -> c.longForQuery(ENDLESS_QUERY) }
+                    }
+                    assertFalse(e.deadlineExceeded)
+                    future.consume()
+                } finally {
+                    worker.requestTermination()
+                }
+                assertEquals(0, conn.longForQuery("select count(*) from test"))
+            }
+        }
+    }
+
+    @Test
+    fun nestedTransactionSharesOuterTransaction() {
         basicTestDb(TWO_COL) {
             it.withConnection {
                 it.withTransaction {
@@ -30,11 +115,12 @@ class DatabaseConnectionTest {
                     statement.bindLong(1, 123)
                     statement.bindString(2, "asdf")
                     statement.executeInsert()
-                    statement.bindLong(1, 123)
-                    statement.bindString(2, "asdf")
-                    statement.executeInsert()
+                    it.withTransaction {
+                        statement.bindLong(1, 123)
+                        statement.bindString(2, "asdf")
+                        statement.executeInsert()
+                    }
                     assertEquals(2, it.longForQuery("select count(*)from test"))
-                    assertFails { it.beginTransaction() }
                     statement.finalizeStatement()
                 }
 
@@ -43,6 +129,128 @@ class DatabaseConnectionTest {
         }
     }
 
+    @Test
+    fun failedNestedTransactionRollsBackToSavepoint() {
+        basicTestDb(TWO_COL) {
+            it.withConnection {
+                it.withTransaction {
+                    it.rawExecSql("INSERT INTO test(num, str)values(1, 'outer')")
+                    assertFails {
+                        it.withTransaction {
+                            it.rawExecSql("INSERT INTO test(num, str)values(2, 'inner')")
+                            it.withTransaction {
+                                it.rawExecSql("INSERT INTO test(num, str)values(3, 'innermost')")
+                            }
+                            throw IllegalStateException("inner fails")
+                        }
+                    }
+                    it.rawExecSql("INSERT INTO test(num, str)values(4, 'outer')")
+                }
+
+                assertEquals(2, it.longForQuery("select count(*)from test"))
+                assertEquals(5, it.longForQuery("select sum(num)from test"))
+            }
+        }
+    }
+
+    @Test
+    fun deepSavepointsCanBeReused() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                fun nest(depth: Int) {
+                    if (depth == 6)
+                        return
+                    conn.withTransaction {
+                        conn.rawExecSql("INSERT INTO test(num, str)values($depth, 'level')")
+                        nest(depth + 1)
+                    }
+                }
+
+                repeat(3) {
+                    conn.withTransaction {
+                        nest(1)
+                        assertFails {
+                            conn.withTransaction {
+                                nest(1)
+                                throw IllegalStateException("discard")
+                            }
+                        }
+                    }
+                }
+
+                assertEquals(15, conn.longForQuery("select count(*)from test"))
+            }
+        }
+    }
+
+    @Test
+    fun outerRollbackDiscardsNestedTransactions() {
+        basicTestDb(TWO_COL) {
+            it.withConnection {
+                it.beginTransaction()
+                it.withTransaction {
+                    it.rawExecSql("INSERT INTO test(num, str)values(1, 'inner')")
+                }
+                it.endTransaction()
+
+                assertEquals(0, it.longForQuery("select count(*)from test"))
+                assertFails { it.endTransaction() }
+            }
+        }
+    }
+
+    @Test
+    fun immediateTransactionTakesWriteLock() {
+        basicTestDb(TWO_COL, timeout = 0) { manager ->
+            val first = manager.createMultiThreadedConnection()
+            val second = manager.createMultiThreadedConnection()
+
+            first.withTransaction(TransactionMode.IMMEDIATE) {
+                assertFails { second.beginTransaction(TransactionMode.IMMEDIATE) }
+                assertFails { second.beginTransaction(TransactionMode.EXCLUSIVE) }
+                second.withTransaction { conn ->
+                    assertEquals(0, conn.longForQuery("select count(*)from test"))
+                }
+            }
+
+            second.withTransaction(TransactionMode.EXCLUSIVE) { conn ->
+                conn.rawExecSql("INSERT INTO test(num, str)values(1, 'a')")
+            }
+            assertEquals(1, first.longForQuery("select count(*)from test"))
+
+            first.close()
+            second.close()
+        }
+    }
+
+    @Test
+    fun defaultTransactionModeSkipsReadOnlyConnections() {
+        val manager = createDatabaseManager(
+            DatabaseConfiguration(
+                name = TEST_DB_NAME,
+                version = 1,
+                create = { db ->
+                    db.withStatement(TWO_COL) {
+                        execute()
+                    }
+                },
+                extendedConfig = DatabaseConfiguration.Extended(transactionMode = TransactionMode.IMMEDIATE),
+                loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+            )
+        )
+
+        try {
+            val pool = manager.createConnectionPool()
+            pool.write { conn ->
+                conn.withTransaction { it.rawExecSql("INSERT INTO test(num, str)values(1, 'a')") }
+            }
+            assertEquals(1, pool.read { conn -> conn.withTransaction { it.longForQuery("select count(*)from test") } })
+            pool.close()
+        } finally {
+            deleteDatabase(TEST_DB_NAME)
+        }
+    }
+
     @Test
     fun rollbackLosesStatements() {
         basicTestDb(TWO_COL) {
@@ -370,6 +578,57 @@ class DatabaseConnectionTest {
         }
     }
 
+    @Test
+    fun incrementalBlobIO() {
+        basicTestDb("CREATE TABLE test (id INTEGER PRIMARY KEY, data BLOB)") { databaseManager ->
+            databaseManager.withConnection {
+                val chunk = ByteArray(1024) { i -> i.toByte() }
+                val rowIds = (0 until 2).map { _ ->
+                    it.withStatement("insert into test(data)values(?)") {
+                        bindZeroBlob(1, chunk.size * 8)
+                        executeInsert()
+                    }
+                }
+
+                it.withBlob("test", "data", rowIds[0], writable = true) {
+                    assertEquals(chunk.size * 8, size)
+                    for (i in 0 until 8) {
+                        write(i * chunk.size, chunk)
+                    }
+
+                    reopen(rowIds[1])
+                    write(0, chunk, 512, 256)
+                }
+
+                it.withBlob("test", "data", rowIds[0]) {
+                    assertFalse(writable)
+                    val buffer = ByteArray(chunk.size)
+                    read(chunk.size * 7, buffer)
+                    assertContentEquals(chunk, buffer)
+
+                    reopen(rowIds[1])
+                    read(0, buffer, 0, 256)
+                    assertContentEquals(chunk.copyOfRange(512, 768), buffer.copyOf(256))
+
+                    assertFails { write(0, buffer) }
+                    assertFails { read(size - 10, buffer) }
+                    assertFailsWith<IndexOutOfBoundsException> { read(0, buffer, 1000, 100) }
+                }
+
+                assertFails { it.openBlob("test", "data", 1234) }
+
+                val closed = it.openBlob("test", "data", rowIds[0], writable = true)
+                closed.close()
+                closed.close()
+                val buffer = ByteArray(16)
+                assertFailsWith<IllegalStateException> { closed.size }
+                assertFailsWith<IllegalStateException> { closed.read(0, buffer) }
+                assertFailsWith<IllegalStateException> { closed.write(0, buffer) }
+                assertFailsWith<IllegalStateException> { closed.reopen(rowIds[1]) }
+            }
+        }
+    }
+
     private fun checkDbIsFile(memoryName: String?, mem:Boolean): Boolean {
         var dbFileExists = false
         val checkName = memoryName ?: ":memory:"
@@ -406,4 +665,9 @@ class DatabaseConnectionTest {
         }
         return dbFileExists
     }
-}
\ No newline at end of file
+}
+
+private const val ENDLESS_QUERY = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c"
+
+private const val ENDLESS_INSERT = "INSERT INTO test(num, str) " +
+        "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT x, 'row' FROM c"
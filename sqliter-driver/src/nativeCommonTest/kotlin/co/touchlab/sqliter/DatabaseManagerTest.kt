@@ -17,12 +17,83 @@
 package co.touchlab.sqliter
 
 import co.touchlab.sqliter.DatabaseFileContext.deleteDatabase
+import co.touchlab.sqliter.native.LatencyHistogram
+import co.touchlab.sqliter.native.StatementMetrics
 import co.touchlab.sqliter.native.increment
 import kotlin.concurrent.AtomicInt
 import kotlin.test.*
 
 class DatabaseManagerTest : BaseDatabaseTest(){
 
+    @Test
+    fun statementMetricsPerFingerprint(){
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger, statementMetrics = true)
+        ))
+
+        manager.withConnection { conn ->
+            manager.resetStatementMetrics()
+            for (i in 0 until 10) {
+                conn.withStatement("insert into test(num, str)values(?,?)") {
+                    bindLong(1, i.toLong())
+                    bindString(2, "row $i")
+                    executeInsert()
+                }
+            }
+            conn.withStatement("select  num,\n str from test") {
+                val cursor = query()
+                while (cursor.next()) {
+                    cursor.getLong(0)
+                }
+            }
+        }
+
+        val metrics = manager.statementMetrics().associateBy { it.sql }
+        val insert = metrics.getValue("insert into test(num, str)values(?,?)")
+        assertEquals(10, insert.count)
+        assertTrue(insert.p50Nanos <= insert.p99Nanos)
+        assertTrue(insert.p99Nanos <= insert.maxNanos)
+        assertEquals(1, metrics.getValue("select num, str from test").count)
+    }
+
+    @Test
+    fun fingerprintReplacesLiterals(){
+        assertEquals(
+            "select * from t1 where id = ? and name = ? and data = ? and score > ?",
+            StatementMetrics.fingerprint("  select * from t1\n where id = 42 and name = 'it''s' and data = x'0aFF' and score > 1.5e-3 ")
+        )
+        assertEquals(
+            "select \"col 1\", [2nd] from t where a = ?1 and b = :b limit ?",
+            StatementMetrics.fingerprint("select \"col 1\", [2nd] from t where a = ?1 and b = :b limit 0x10")
+        )
+    }
+
+    @Test
+    fun statementMetricsOffByDefault(){
+        basicTestDb { man ->
+            man.withConnection { it.longForQuery("select count(*) from test") }
+            assertTrue(man.statementMetrics().isEmpty())
+        }
+    }
+
+    @Test
+    fun latencyHistogramBuckets(){
+        for (value in listOf(0L, 1L, 3L, 4L, 7L, 8L, 1000L, 123_456_789L, Long.MAX_VALUE)) {
+            val bucket = LatencyHistogram.bucketFor(value)
+            assertTrue(value <= LatencyHistogram.bucketUpperBound(bucket), "value $value bucket $bucket")
+            if (bucket > 0)
+                assertTrue(value > LatencyHistogram.bucketUpperBound(bucket - 1), "value $value bucket $bucket")
+        }
+        assertEquals(LatencyHistogram.BUCKET_COUNT - 1, LatencyHistogram.bucketFor(Long.MAX_VALUE))
+    }
+
     @Test
     fun connectionCount(){
         val connectionCount = AtomicInt(0)
@@ -290,6 +361,110 @@ class DatabaseManagerTest : BaseDatabaseTest(){
             assertEquals(1, it.longForQuery("select count(*) from test2"))
         }
     }
+
+    @Test
+    fun backupAndVacuumInto(){
+        basicTestDb(TWO_COL) { man ->
+            man.withConnection { conn ->
+                conn.withStatement("insert into test(num, str)values(?,?)") {
+                    executeBatch(500) { i ->
+                        bindLong(1, i.toLong())
+                        bindString(2, "row $i")
+                    }
+                }
+            }
+
+            val backupConfig = DatabaseConfiguration(
+                name = "backupdb",
+                version = NO_VERSION_CHECK,
+                create = {},
+                loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger)
+            )
+            val vacuumName = "vacuumdb"
+            try {
+                var steps = 0
+                var lastRemaining = -1
+                man.backupTo(backupConfig, pagesPerStep = 1, stepDelayMillis = 0) { remaining, total ->
+                    steps++
+                    lastRemaining = remaining
+                    assertTrue(remaining <= total)
+                }
+                assertTrue(steps > 1)
+                assertEquals(0, lastRemaining)
+                createDatabaseManager(backupConfig).withConnection {
+                    assertEquals(500, it.longForQuery("select count(*) from test"))
+                }
+
+                val vacuumPath = DatabaseFileContext.databasePath(vacuumName, null)
+                man.vacuumInto(vacuumPath)
+                createDatabaseManager(backupConfig.copy(name = vacuumName)).withConnection {
+                    assertEquals(500, it.longForQuery("select count(*) from test"))
+                }
+                assertFails { man.vacuumInto(vacuumPath) }
+                assertFails { man.backupTo(backupConfig, stepDelayMillis = -1) }
+            } finally {
+                deleteDatabase("backupdb")
+                deleteDatabase(vacuumName)
+            }
+        }
+    }
+
+    @Test
+    fun tableChangesPublishedAfterCommit(){
+        basicTestDb(TWO_COL) { man ->
+            val published = mutableListOf<Set<String>>()
+            val listener = object : TableChangeListener {
+                override fun onTablesChanged(tables: Set<String>) {
+                    published.add(tables)
+                }
+            }
+            man.addTableChangeListener(listener)
+
+            man.withConnection { conn ->
+                conn.rawExecSql("create table other(id integer primary key)")
+                published.clear()
+
+                conn.withStatement("insert into test(num, str)values(?,?)") {
+                    bindLong(1, 1)
+                    bindString(2, "a")
+                    executeInsert()
+                }
+                assertEquals(listOf(setOf("test")), published)
+
+                published.clear()
+                conn.withTransaction {
+                    it.rawExecSql("insert into test(num, str)values(2, 'b')")
+                    it.rawExecSql("insert into other(id)values(1)")
+                    it.rawExecSql("insert into test(num, str)values(3, 'c')")
+                    assertTrue(published.isEmpty())
+                }
+                assertEquals(listOf(setOf("test", "other")), published)
+
+                published.clear()
+                conn.beginTransaction()
+                conn.rawExecSql("insert into other(id)values(2)")
+                conn.endTransaction()
+                conn.longForQuery("select count(*) from test")
+                assertTrue(published.isEmpty())
+
+                //Each commit is published once, as one set, by the connection that made it
+                published.clear()
+                man.withConnection { other ->
+                    other.withTransaction {
+                        it.rawExecSql("insert into test(num, str)values(4, 'd')")
+                        it.rawExecSql("insert into test(num, str)values(5, 'e')")
+                    }
+                }
+                conn.rawExecSql("insert into test(num, str)values(6, 'f')")
+                assertEquals(listOf(setOf("test"), setOf("test")), published)
+
+                published.clear()
+                man.removeTableChangeListener(listener)
+                conn.rawExecSql("insert into other(id)values(3)")
+                assertTrue(published.isEmpty())
+            }
+        }
+    }
 }
 
 private fun AtomicInt.decrement() {
@@ -367,6 +367,109 @@ class NativeDatabaseConnectionTest : BaseDatabaseTest(){
         stmt.finalizeStatement()
     }
 
+    @Test
+    fun statementCacheReusesStatements(){
+        val manager = cachedDb(4)
+        val conn = manager.createSingleThreadedConnection()
+        try {
+            val before = conn.statementCacheStats()
+            val s1 = conn.createStatement("insert into test(num, str)values(?,?)")
+            s1.bindLong(1, 1)
+            s1.bindString(2, "a")
+            s1.executeInsert()
+            s1.finalizeStatement()
+
+            val s2 = conn.createStatement("insert into test(num, str)values(?,?)")
+            assertSame(s1, s2)
+            s2.bindLong(1, 2)
+            s2.bindString(2, "b")
+            s2.executeInsert()
+            s2.finalizeStatement()
+
+            val after = conn.statementCacheStats()
+            assertEquals(before.misses + 1, after.misses)
+            assertEquals(before.hits + 1, after.hits)
+            assertEquals(2, conn.longForQuery("select count(*) from test"))
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun statementCacheSameSqlInUseGetsNewStatement(){
+        val manager = cachedDb(4)
+        val conn = manager.createSingleThreadedConnection()
+        try {
+            val s1 = conn.createStatement("select * from test")
+            val s2 = conn.createStatement("select * from test")
+            assertNotSame(s1, s2)
+            s1.finalizeStatement()
+            s2.finalizeStatement()
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun statementCacheEvictsLeastRecentlyUsed(){
+        val manager = cachedDb(2)
+        val conn = manager.createSingleThreadedConnection()
+        try {
+            conn.withStatement("select num from test") { }
+            conn.withStatement("select str from test") { }
+            val evictionsBefore = conn.statementCacheStats().evictions
+            conn.withStatement("select num, str from test") { }
+
+            val stats = conn.statementCacheStats()
+            assertEquals(2, stats.size)
+            assertEquals(evictionsBefore + 1, stats.evictions)
+
+            //Most recent two stay cached
+            val hitsBefore = stats.hits
+            conn.withStatement("select str from test") { }
+            conn.withStatement("select num, str from test") { }
+            assertEquals(hitsBefore + 2, conn.statementCacheStats().hits)
+        } finally {
+            conn.close()
+        }
+    }
+
+    @Test
+    fun statementCacheClearsBindingsOnReturn(){
+        val manager = cachedDb(4)
+        val conn = manager.createMultiThreadedConnection()
+        try {
+            conn.withStatement("insert into test(num, str)values(?,?)") {
+                bindLong(1, 1)
+                bindString(2, "a")
+                executeInsert()
+            }
+            conn.withStatement("select count(*) from test where num = ?") {
+                bindLong(1, 1)
+                assertEquals(1, longForQuery())
+            }
+            conn.withStatement("select count(*) from test where num = ?") {
+                //Bindings were cleared, so this compares against null
+                assertEquals(0, longForQuery())
+            }
+        } finally {
+            conn.close()
+        }
+    }
+
+    private fun cachedDb(cacheSize: Int) = createDatabaseManager(
+        DatabaseConfiguration(
+            name = TEST_DB_NAME, version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            extendedConfig = DatabaseConfiguration.Extended(statementCacheSize = cacheSize),
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+        )
+    )
+
     private fun basicDb() = createDatabaseManager(
         DatabaseConfiguration(
             name = TEST_DB_NAME, version = 1,
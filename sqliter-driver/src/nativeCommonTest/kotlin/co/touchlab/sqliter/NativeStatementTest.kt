@@ -20,6 +20,174 @@ import kotlin.test.*
 
 class NativeStatementTest : BaseDatabaseTest(){
 
+    @Test
+    fun nonAsciiSqlLiteral() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            connection.withStatement("INSERT INTO test VALUES (1, 'héllo wörld ✓ 😀')") {
+                executeInsert()
+            }
+            assertEquals("héllo wörld ✓ 😀", connection.stringForQuery("select str from test where str = 'héllo wörld ✓ 😀'"))
+            connection.close()
+        }
+    }
+
+    @Test
+    fun executeBatchReturnsRowIds() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            val rows = (1..100).map { i -> Pair(i.toLong(), "row $i") }
+            val rowIds = connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                executeBatch(rows) { row ->
+                    bindLong(1, row.first)
+                    bindString(2, row.second)
+                }
+            }
+            assertEquals(100, rowIds.size)
+            assertEquals(1L, rowIds.first())
+            assertEquals(100L, rowIds.last())
+            assertEquals(100, connection.longForQuery("select count(*) from test"))
+            connection.close()
+        }
+    }
+
+    @Test
+    fun executeBatchColumnarChangedRows() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            val nums = LongArray(10) { i -> i.toLong() }
+            val strs = Array(10) { i -> "row $i" }
+            connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                executeBatch(nums.size) { i ->
+                    bindLong(1, nums[i])
+                    bindString(2, strs[i])
+                }
+            }
+
+            val changes = connection.withStatement("UPDATE test SET str = 'x' WHERE num < ?") {
+                executeBatch(sequenceOf(3L, 100L), BatchResult.CHANGED_ROWS) { bindLong(1, it) }
+            }
+            assertContentEquals(longArrayOf(3, 10), changes)
+            connection.close()
+        }
+    }
+
+    @Test
+    fun executeBatchFailureRollsBack() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            assertFails {
+                connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                    executeBatch(listOf("a", "b", null)) { s ->
+                        bindLong(1, 1)
+                        bindString(2, s)
+                    }
+                }
+            }
+            assertEquals(0, connection.longForQuery("select count(*) from test"))
+            connection.close()
+        }
+    }
+
+    @Test
+    fun executeBatchClearsBindingsBetweenRows() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            //The second row doesn't bind str, so it's null and fails the NOT NULL constraint
+            assertFails {
+                connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                    executeBatch(listOf(1L, 2L)) { num ->
+                        bindLong(1, num)
+                        if (num == 1L)
+                            bindString(2, "row $num")
+                    }
+                }
+            }
+            assertEquals(0, connection.longForQuery("select count(*) from test"))
+            connection.close()
+        }
+    }
+
+    @Test
+    fun executeBatchJoinsOpenTransaction() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            connection.beginTransaction()
+            connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                executeBatch(listOf("a", "b")) { s ->
+                    bindLong(1, 1)
+                    bindString(2, s)
+                }
+            }
+            connection.endTransaction()
+            assertEquals(0, connection.longForQuery("select count(*) from test"))
+            connection.close()
+        }
+    }
+
+    @Test
+    fun statementStatsShowFullScan() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            connection.withStatement("INSERT INTO test VALUES (?, ?)") {
+                executeBatch(10) { i ->
+                    bindLong(1, i.toLong())
+                    bindString(2, "row $i")
+                }
+            }
+            connection.withStatement("select num from test where str = ?") {
+                bindString(1, "row 5")
+                val cursor = query()
+                while (cursor.next()) {
+                    cursor.getLong(0)
+                }
+                resetStatement()
+
+                val stats = stats(reset = true)
+                assertTrue(stats.fullScanSteps > 0)
+                assertTrue(stats.vmSteps > 0)
+                assertEquals(1, stats.runs)
+                assertTrue(stats.memoryUsed > 0)
+
+                assertEquals(0, stats().fullScanSteps)
+            }
+            connection.close()
+        }
+    }
+
+    @Test
+    fun statementStatsRollUpPerSql() {
+        val manager = createDatabaseManager(DatabaseConfiguration(
+            name = TEST_DB_NAME,
+            version = 1,
+            create = { db ->
+                db.withStatement(TWO_COL) {
+                    execute()
+                }
+            },
+            loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger, statementMetrics = true)
+        ))
+        val connection = manager.surpriseMeConnection()
+        for (i in 0 until 3) {
+            connection.withStatement("select count(*) from test where str = 'x'") {
+                longForQuery()
+            }
+        }
+        val stats = connection.statementStats().getValue("select count(*) from test where str = 'x'")
+        assertEquals(3, stats.runs)
+        connection.close()
+    }
+
+    @Test
+    fun emptySqlFails() {
+        basicTestDb(TWO_COL) {
+            val connection = it.surpriseMeConnection()
+            assertFails { connection.createStatement("") }
+            assertFails { connection.createStatement("  -- nothing here") }
+            connection.close()
+        }
+    }
+
     @Test
     fun insertStatement() {
         basicTestDb {
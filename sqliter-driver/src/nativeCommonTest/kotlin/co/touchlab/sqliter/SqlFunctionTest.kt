@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter
+
+import co.touchlab.sqliter.interop.SQLiteException
+import kotlin.test.*
+
+class SqlFunctionTest : BaseDatabaseTest() {
+
+    @Test
+    fun scalarFunction() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                insertRows(conn, 5)
+                conn.registerFunction("double_it", 1, deterministic = true) { args ->
+                    if (args.isNull(0)) setNull() else setLong(args.getLong(0) * 2)
+                }
+                assertEquals(20, conn.longForQuery("select sum(double_it(num)) from test"))
+                assertEquals(0, conn.longForQuery("select count(double_it(null))"))
+
+                //Only deterministic functions can be indexed
+                conn.rawExecSql("create index test_double on test(double_it(num))")
+                assertEquals(3, conn.longForQuery("select num from test where double_it(num) = 6"))
+            }
+        }
+    }
+
+    @Test
+    fun scalarArgumentTypes() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                conn.registerFunction("describe", -1) { args ->
+                    setString((0 until args.size).joinToString(",") { i ->
+                        when (args.getType(i)) {
+                            FieldType.TYPE_INTEGER -> "i${args.getLong(i)}"
+                            FieldType.TYPE_FLOAT -> "f${args.getDouble(i)}"
+                            FieldType.TYPE_TEXT -> "t${args.getString(i)}"
+                            FieldType.TYPE_BLOB -> "b${args.getBytes(i).size}"
+                            FieldType.TYPE_NULL -> "n"
+                        }
+                    })
+                }
+                assertEquals("i1,f1.5,tabc,b3,n", conn.stringForQuery("select describe(1, 1.5, 'abc', x'010203', null)"))
+            }
+        }
+    }
+
+    @Test
+    fun functionErrorsFailStatement() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                conn.registerFunction("explode", 0) { _ -> throw IllegalStateException("boom") }
+                conn.registerFunction("reject", 0) { _ -> setError("rejected") }
+                assertFailsWith<SQLiteException> { conn.longForQuery("select explode()") }
+                assertFailsWith<SQLiteException> { conn.longForQuery("select reject()") }
+                assertEquals(1, conn.longForQuery("select 1"))
+            }
+        }
+    }
+
+    @Test
+    fun aggregateFunction() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                insertRows(conn, 4)
+                conn.registerAggregateFunction("sum_squares", 1, deterministic = true) { SumSquares() }
+                assertEquals(30, conn.longForQuery("select sum_squares(num) from test"))
+                //Empty groups still get a result
+                assertEquals(0, conn.longForQuery("select sum_squares(num) from test where num > 100"))
+                assertEquals(2, conn.longForQuery("select count(*) from (select num % 2, sum_squares(num) from test group by num % 2)"))
+            }
+        }
+    }
+
+    @Test
+    fun windowFunction() {
+        basicTestDb(TWO_COL) {
+            it.withConnection { conn ->
+                insertRows(conn, 4)
+                conn.registerWindowFunction("sum_squares", 1, deterministic = true) { SumSquares() }
+                val sums = conn.withStatement(
+                    "select sum_squares(num) over (order by num rows between 1 preceding and current row) from test order by num"
+                ) {
+                    val cursor = query()
+                    val result = mutableListOf<Long>()
+                    while (cursor.next()) {
+                        result.add(cursor.getLong(0))
+                    }
+                    result
+                }
+                assertEquals(listOf(1L, 5L, 13L, 25L), sums)
+            }
+        }
+    }
+
+    @Test
+    fun configuredFunctionsOnEveryConnection() {
+        val manager = createDatabaseManager(
+            DatabaseConfiguration(
+                name = TEST_DB_NAME,
+                version = 1,
+                create = { db ->
+                    //Available during migrations
+                    db.rawExecSql("CREATE TABLE test (num INTEGER NOT NULL); CREATE VIEW doubled AS SELECT double_it(num) AS d FROM test")
+                },
+                loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+                extendedConfig = DatabaseConfiguration.Extended(
+                    functions = listOf(SqlFunction.Scalar("double_it", 1, deterministic = true) { args ->
+                        setLong(args.getLong(0) * 2)
+                    })
+                )
+            )
+        )
+        manager.withConnection { conn -> conn.rawExecSql("insert into test(num) values (21)") }
+        val pool = manager.createConnectionPool()
+        try {
+            assertEquals(42, pool.read { conn -> conn.longForQuery("select d from doubled") })
+            assertEquals(8, pool.read { conn -> conn.longForQuery("select double_it(4)") })
+        } finally {
+            pool.close()
+        }
+    }
+
+    private fun insertRows(conn: DatabaseConnection, count: Int) {
+        conn.withStatement("insert into test(num, str)values(?,?)") {
+            executeBatch(count) { i ->
+                bindLong(1, i + 1L)
+                bindString(2, "row $i")
+            }
+        }
+    }
+
+    private class SumSquares : SqlWindowAggregate {
+        private var total = 0L
+
+        override fun step(args: SqlArguments) {
+            val value = args.getLong(0)
+            total += value * value
+        }
+
+        override fun inverse(args: SqlArguments) {
+            val value = args.getLong(0)
+            total -= value * value
+        }
+
+        override fun result(result: SqlResult) {
+            result.setLong(total)
+        }
+    }
+}
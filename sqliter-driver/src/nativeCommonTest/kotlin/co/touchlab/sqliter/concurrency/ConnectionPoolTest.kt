@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.concurrency
+
+import co.touchlab.sqliter.*
+import co.touchlab.sqliter.native.FairConnectionQueue
+import kotlin.concurrent.AtomicInt
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFails
+
+class ConnectionPoolTest : BaseDatabaseTest() {
+
+    @Test
+    fun readSeesWrites() {
+        basicTestDb(TWO_COL) {
+            val pool = it.createConnectionPool()
+            try {
+                pool.write { conn ->
+                    conn.withStatement("insert into test(num, str)values(?,?)") {
+                        bindLong(1, 1)
+                        bindString(2, "a")
+                        executeInsert()
+                    }
+                }
+                assertEquals(1, pool.read { conn -> conn.longForQuery("select count(*) from test") })
+            } finally {
+                pool.close()
+            }
+        }
+    }
+
+    @Test
+    fun readersAreReadOnly() {
+        basicTestDb(TWO_COL) {
+            val pool = it.createConnectionPool()
+            try {
+                assertFails {
+                    pool.read { conn ->
+                        conn.withStatement("insert into test(num, str)values(?,?)") {
+                            bindLong(1, 1)
+                            bindString(2, "a")
+                            executeInsert()
+                        }
+                    }
+                }
+            } finally {
+                pool.close()
+            }
+        }
+    }
+
+    @Test
+    fun concurrentReads() {
+        basicTestDb(TWO_COL) {
+            val pool = it.createConnectionPool()
+            pool.write { conn ->
+                conn.withStatement("insert into test(num, str)values(?,?)") {
+                    executeBatch(1000) { i ->
+                        bindLong(1, i.toLong())
+                        bindString(2, "row $i")
+                    }
+                }
+            }
+
+            val readCount = AtomicInt(0)
+            val ops = ThreadOps { Unit }
+            for (i in 0 until 20) {
+                ops.exe {
+                    val count = pool.read { conn -> conn.longForQuery("select count(*) from test") }
+                    if (count == 1000L)
+                        readCount.incrementAndGet()
+                }
+            }
+            ops.exe {
+                pool.write { conn ->
+                    conn.withStatement("insert into test(num, str)values(?,?)") {
+                        bindLong(1, -1)
+                        bindString(2, "late")
+                        executeInsert()
+                    }
+                }
+            }
+            ops.run(6)
+
+            assertEquals(1001, pool.read { conn -> conn.longForQuery("select count(*) from test") })
+            pool.close()
+            assertFails { pool.read { } }
+        }
+    }
+
+    @Test
+    fun failedOpenReleasesSlot() {
+        basicTestDb(TWO_COL) {
+            val attempts = AtomicInt(0)
+            val queue = FairConnectionQueue(1) {
+                if (attempts.incrementAndGet() == 1)
+                    throw IllegalStateException("open failed")
+                it.createSingleThreadedConnection()
+            }
+            assertFails { queue.acquire() }
+            queue.release(queue.acquire())
+            assertEquals(2, attempts.value)
+            queue.close()
+        }
+    }
+
+    @Test
+    fun inMemoryReadsUseWriter() {
+        val manager = createDatabaseManager(
+            DatabaseConfiguration(
+                name = null,
+                inMemory = true,
+                version = 1,
+                create = { db ->
+                    db.withStatement(TWO_COL) {
+                        execute()
+                    }
+                },
+                loggingConfig = DatabaseConfiguration.Logging(logger = NoneLogger),
+            )
+        )
+        val pool = manager.createConnectionPool()
+        pool.write { conn -> conn.rawExecSql("insert into test(num, str)values(1, 'a')") }
+        assertEquals(1, pool.read { conn -> conn.longForQuery("select count(*) from test") })
+        pool.close()
+    }
+}
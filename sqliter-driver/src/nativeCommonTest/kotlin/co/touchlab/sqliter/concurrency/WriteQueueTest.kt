@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018 Touchlab, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package co.touchlab.sqliter.concurrency
+
+import co.touchlab.sqliter.*
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFails
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+class WriteQueueTest : BaseDatabaseTest() {
+
+    @Test
+    fun failedWriteOnlyRollsBackItself() {
+        basicTestDb(TWO_COL) {
+            val queue = it.createWriteQueue()
+            try {
+                val first = queue.submit { conn -> insert(conn, 1) }
+                val bad = queue.submit<Long> { conn ->
+                    insert(conn, 2)
+                    throw IllegalStateException("bad write")
+                }
+                val last = queue.submit { conn -> insert(conn, 3) }
+
+                assertTrue(first.await() > 0)
+                assertFailsWith<IllegalStateException> { bad.await() }
+                assertTrue(last.await() > 0)
+                assertTrue(bad.isDone)
+            } finally {
+                queue.close()
+            }
+
+            it.withConnection { conn ->
+                assertEquals(2, conn.longForQuery("select count(*) from test"))
+                assertEquals(0, conn.longForQuery("select count(*) from test where num = 2"))
+            }
+        }
+    }
+
+    @Test
+    fun concurrentWrites() {
+        basicTestDb(TWO_COL) {
+            val queue = it.createWriteQueue()
+            val ops = ThreadOps { Unit }
+            for (i in 0 until 500) {
+                ops.exe {
+                    queue.write { conn -> insert(conn, i) }
+                }
+            }
+            ops.run(8)
+
+            assertEquals(500, queue.write { conn -> conn.longForQuery("select count(*) from test") })
+            queue.close()
+        }
+    }
+
+    @Test
+    fun closeRunsQueuedWrites() {
+        basicTestDb(TWO_COL) {
+            val queue = it.createWriteQueue()
+            val pending = (0 until 50).map { i -> queue.submit { conn -> insert(conn, i) } }
+            queue.close()
+
+            assertTrue(pending.all { p -> p.isDone })
+            assertFails { queue.submit { } }
+            it.withConnection { conn ->
+                assertEquals(50, conn.longForQuery("select count(*) from test"))
+            }
+        }
+    }
+
+    private fun insert(conn: DatabaseConnection, num: Int): Long =
+        conn.withStatement("insert into test(num, str)values(?,?)") {
+            bindLong(1, num.toLong())
+            bindString(2, "row $num")
+            executeInsert()
+        }
+}
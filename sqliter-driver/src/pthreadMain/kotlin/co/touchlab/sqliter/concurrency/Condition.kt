@@ -0,0 +1,78 @@
+package co.touchlab.sqliter.concurrency
+
+import kotlin.concurrent.AtomicInt
+import kotlin.native.ref.createCleaner
+import kotlinx.cinterop.Arena
+import kotlinx.cinterop.alloc
+import kotlinx.cinterop.convert
+import kotlinx.cinterop.memScoped
+import kotlinx.cinterop.ptr
+import platform.posix.*
+
+/**
+ * Shared by the linux and mingw targets. PthreadMutexVar and PthreadCondVar come from each target's source set.
+ */
+internal actual class Condition actual constructor() {
+    private val handles = PthreadCondition()
+
+    //Frees the mutex and condition once the Condition is unreachable, unless close() already did
+    @Suppress("unused")
+    private val cleaner = createCleaner(handles) { it.destroy() }
+
+    actual fun lock() {
+        pthread_mutex_lock(handles.mutex.ptr)
+    }
+
+    actual fun unlock() {
+        pthread_mutex_unlock(handles.mutex.ptr)
+    }
+
+    actual fun await() {
+        pthread_cond_wait(handles.cond.ptr, handles.mutex.ptr)
+    }
+
+    actual fun await(timeoutNanos: Long) {
+        memScoped {
+            // pthread_cond_timedwait takes an absolute CLOCK_REALTIME deadline
+            val deadline = alloc<timespec>()
+            clock_gettime(CLOCK_REALTIME, deadline.ptr)
+            val nanos = deadline.tv_nsec.toLong() + timeoutNanos % 1_000_000_000L
+            deadline.tv_sec = (deadline.tv_sec.toLong() + timeoutNanos / 1_000_000_000L + nanos / 1_000_000_000L).convert()
+            deadline.tv_nsec = (nanos % 1_000_000_000L).convert()
+            pthread_cond_timedwait(handles.cond.ptr, handles.mutex.ptr, deadline.ptr)
+        }
+    }
+
+    actual fun signalAll() {
+        pthread_cond_broadcast(handles.cond.ptr)
+    }
+
+    fun internalClose() {
+        handles.destroy()
+    }
+}
+
+//Kept apart from Condition so the cleaner doesn't hold a reference to it
+private class PthreadCondition {
+    private val arena = Arena()
+    val mutex = arena.alloc<PthreadMutexVar>()
+    val cond = arena.alloc<PthreadCondVar>()
+    private val destroyed = AtomicInt(0)
+
+    init {
+        pthread_mutex_init(mutex.ptr, null)
+        pthread_cond_init(cond.ptr, null)
+    }
+
+    fun destroy() {
+        if (!destroyed.compareAndSet(0, 1))
+            return
+        pthread_cond_destroy(cond.ptr)
+        pthread_mutex_destroy(mutex.ptr)
+        arena.clear()
+    }
+}
+
+internal actual inline fun Condition.close() {
+    internalClose()
+}